@@ -10,7 +10,11 @@
 #include <fstream>      // For file stream operations
 #include <sstream>      // For string stream operations
 #include <cassert>      // For the assert macro
+#include <cstdio>       // For std::snprintf
 #include <limits>       // For numeric limits
+#include <cstdint>      // For fixed width integer types
+#include <cmath>        // For std::fmod and std::lround
+#include <algorithm>    // For std::max, std::min, std::sort etc.
 
 // Containers
 #include <vector>       // For std::vector
@@ -21,9 +25,13 @@
 
 // Bit Manipulation
 #include <bitset>       // For std::bitset
+#include <bit>          // For std::countr_zero and std::popcount
 
 // Memory Management
 #include <memory>       // For std::shared_ptr, std::unique_ptr, std::weak_ptr, std::make_shared, std::make_unique etc.
+#include <new>          // For placement new and std::launder
+#include <cstring>      // For std::memcpy
+#include <cstddef>      // For std::byte and std::max_align_t
 
 // Type Information
 #include <typeinfo>     // For typeid operator and std::type_info
@@ -33,8 +41,27 @@
 #include <future>                 // For std::future
 #include <mutex>                  // For std::mutex
 #include <condition_variable>     // For std::condition_variable
-#include <queue>                  // For std::queue
+#include <deque>                  // For std::deque
 #include <functional>             // For std::function
+#include <chrono>                 // For std::chrono clocks and durations
+#include <coroutine>              // For std::coroutine_handle and std::suspend_always
+#include <exception>              // For std::exception_ptr
+#include <stdexcept>              // For std::length_error and std::logic_error
+#include <type_traits>            // For std::invoke_result_t
+#include <utility>                // For std::exchange
+#include <atomic>                 // For std::atomic
+#include <span>                   // For std::span
+
+// Platform
+#include <filesystem>             // For reading the NUMA topology from /sys
+#ifdef __linux__
+#include <pthread.h>              // For pthread_setaffinity_np
+#include <sched.h>                // For cpu_set_t and sched_getaffinity
+#include <sys/mman.h>             // For mmap, madvise and shm_open
+#include <sys/stat.h>             // For fstat
+#include <fcntl.h>                // For the O_* flags
+#include <unistd.h>               // For ftruncate and close
+#endif
 
 // Type definitions
 using EntityId = unsigned int;
@@ -42,20 +69,205 @@ using ComponentTypeId = unsigned int;
 
 
 using EventId = unsigned int;
-using EventHandler = std::function<void()>;
-using EventCondition = std::function<bool()>;
+
+using ClientId = unsigned int;
+
+using TimerId = std::uint64_t;
+using TimerCallback = std::function<void()>;
 
 // Constants
 constexpr EntityId MAX_ENTITIES = 1000;
 constexpr ComponentTypeId MAX_COMPONENTS = 32;
+constexpr unsigned int ANY_NUMA_NODE = std::numeric_limits<unsigned int>::max();
+constexpr std::size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+constexpr EntityId ENTITY_ID_BATCH = 16; // Ids a thread reserves at once when creating entities concurrently
+constexpr std::size_t ENTITY_RESERVATION_SLOTS = 64; // Threads that can hold a batch of ids at once, any others take ids one at a time
+constexpr std::size_t EVENT_BATCH_SIZE = 64; // Thread safe conditions or parallel handlers per worker pool job
+constexpr std::size_t DELEGATE_CAPACITY = 32; // Bytes of captured state a Delegate holds inline
+constexpr std::size_t REPLICATION_WINDOW = 64; // Unacknowledged packets remembered per client
+constexpr std::size_t SIGNATURE_CACHE_SIZE = 256; // Component lists whose signatures a Context caches, later ones are built on every call
+constexpr std::size_t FUSION_BLOCK_SIZE = 256; // Entities each system in a fused chain processes before handing over to the next
 
 // Signature type (uses MAX_COMPONENTS
 using Signature = std::bitset<MAX_COMPONENTS>;
+static_assert(MAX_COMPONENTS <= 64, "Signatures are scanned through an unsigned long long");
+
+// Calls function with the id of every component type set in the signature, in ascending order
+template<typename Function>
+void forEachComponentType(const Signature& signature, Function&& function) {
+    for (auto bits = signature.to_ullong(); bits != 0; bits &= bits - 1)
+        function(static_cast<ComponentTypeId>(std::countr_zero(bits)));
+}
 
 // Null values
 constexpr auto tnull = MAX_ENTITIES;
 constexpr auto tnullptr = nullptr;
 
+// Dense indices handed out per type on first use and fixed for the rest of the process, one sequence per Family.
+// Contexts use them to look up type ids and cached signatures in arrays instead of maps
+struct ComponentTypeFamily {};
+struct SignatureFamily {};
+
+template<typename Family>
+class TypeIndex {
+public:
+    template<typename... Types>
+    static std::size_t get() {
+        static const std::size_t index = s_NextIndex.fetch_add(1, std::memory_order_relaxed);
+        return index;
+    }
+private:
+    inline static std::atomic<std::size_t> s_NextIndex = 0;
+};
+
+// Delegates
+// A std::function replacement that never allocates: the callable lives in an inline buffer, and one that doesn't fit fails to compile.
+// Trivially copyable callables (most lambdas capturing pointers, references and ids) are copied without going through a manager.
+template<typename Signature, std::size_t Capacity = DELEGATE_CAPACITY>
+class Delegate;
+
+template<typename R, typename... Args, std::size_t Capacity>
+class Delegate<R(Args...), Capacity> {
+public:
+    Delegate() = default;
+    Delegate(std::nullptr_t) {}
+    template<typename F>
+        requires (!std::is_same_v<std::decay_t<F>, Delegate> && std::is_invocable_r_v<R, std::decay_t<F>&, Args...>)
+    Delegate(F&& function);
+    Delegate(const Delegate& other);
+    Delegate(Delegate&& other) noexcept;
+    Delegate& operator=(const Delegate& other);
+    Delegate& operator=(Delegate&& other) noexcept;
+    ~Delegate() { reset(); }
+
+    // Binds a member function without wrapping it in a lambda, e.g. Delegate<bool()>::bind<&TestSystem::testCondition>(system)
+    template<auto Method, typename T>
+    static Delegate bind(T* instance);
+    template<auto Function>
+    static Delegate bind();
+
+    R operator()(Args... args) const { return m_Invoke(m_Storage, std::forward<Args>(args)...); }
+    explicit operator bool() const { return m_Invoke != nullptr; }
+    void reset();
+
+private:
+    enum class Operation { Copy, Move, Destroy };
+    using Invoker = R(*)(void*, Args&&...);
+    using Manager = void(*)(Operation, void*, void*);
+
+    void copyFrom(const Delegate& other);
+    void moveFrom(Delegate& other) noexcept;
+
+    alignas(std::max_align_t) mutable std::byte m_Storage[Capacity];
+    Invoker m_Invoke = nullptr;
+    Manager m_Manage = nullptr; // Null for trivially copyable callables
+};
+
+// Implement Delegate
+template<typename R, typename... Args, std::size_t Capacity>
+template<typename F>
+    requires (!std::is_same_v<std::decay_t<F>, Delegate<R(Args...), Capacity>> && std::is_invocable_r_v<R, std::decay_t<F>&, Args...>)
+Delegate<R(Args...), Capacity>::Delegate(F&& function) {
+    using Function = std::decay_t<F>;
+    static_assert(sizeof(Function) <= Capacity, "Callable is too large for the delegate's inline storage, capture less or raise the capacity");
+    static_assert(alignof(Function) <= alignof(std::max_align_t), "Callable is over aligned for the delegate's inline storage");
+    static_assert(std::is_nothrow_move_constructible_v<Function>, "Delegates are moved without throwing");
+
+    new (m_Storage) Function(std::forward<F>(function));
+    m_Invoke = [](void* storage, Args&&... args) -> R {
+        return std::invoke(*std::launder(static_cast<Function*>(storage)), std::forward<Args>(args)...);
+    };
+    if constexpr (!std::is_trivially_copyable_v<Function>) {
+        m_Manage = [](const Operation operation, void* target, void* source) {
+            auto* function = std::launder(static_cast<Function*>(source));
+            switch (operation) {
+                case Operation::Copy: new (target) Function(*function); break;
+                case Operation::Move: new (target) Function(std::move(*function)); function->~Function(); break;
+                case Operation::Destroy: function->~Function(); break;
+            }
+        };
+    }
+}
+
+template<typename R, typename... Args, std::size_t Capacity>
+Delegate<R(Args...), Capacity>::Delegate(const Delegate& other) {
+    copyFrom(other);
+}
+
+template<typename R, typename... Args, std::size_t Capacity>
+Delegate<R(Args...), Capacity>::Delegate(Delegate&& other) noexcept {
+    moveFrom(other);
+}
+
+template<typename R, typename... Args, std::size_t Capacity>
+Delegate<R(Args...), Capacity>& Delegate<R(Args...), Capacity>::operator=(const Delegate& other) {
+    if (this != &other) {
+        reset();
+        copyFrom(other);
+    }
+    return *this;
+}
+
+template<typename R, typename... Args, std::size_t Capacity>
+Delegate<R(Args...), Capacity>& Delegate<R(Args...), Capacity>::operator=(Delegate&& other) noexcept {
+    if (this != &other) {
+        reset();
+        moveFrom(other);
+    }
+    return *this;
+}
+
+template<typename R, typename... Args, std::size_t Capacity>
+template<auto Method, typename T>
+Delegate<R(Args...), Capacity> Delegate<R(Args...), Capacity>::bind(T* instance) {
+    return Delegate([instance](Args... args) -> R { return std::invoke(Method, instance, std::forward<Args>(args)...); });
+}
+
+template<typename R, typename... Args, std::size_t Capacity>
+template<auto Function>
+Delegate<R(Args...), Capacity> Delegate<R(Args...), Capacity>::bind() {
+    return Delegate([](Args... args) -> R { return std::invoke(Function, std::forward<Args>(args)...); });
+}
+
+template<typename R, typename... Args, std::size_t Capacity>
+void Delegate<R(Args...), Capacity>::reset() {
+    if (m_Manage)
+        m_Manage(Operation::Destroy, nullptr, m_Storage);
+    m_Invoke = nullptr;
+    m_Manage = nullptr;
+}
+
+template<typename R, typename... Args, std::size_t Capacity>
+void Delegate<R(Args...), Capacity>::copyFrom(const Delegate& other) {
+    if (other.m_Manage)
+        other.m_Manage(Operation::Copy, m_Storage, other.m_Storage);
+    else if (other.m_Invoke)
+        std::memcpy(m_Storage, other.m_Storage, Capacity);
+    m_Invoke = other.m_Invoke;
+    m_Manage = other.m_Manage;
+}
+
+template<typename R, typename... Args, std::size_t Capacity>
+void Delegate<R(Args...), Capacity>::moveFrom(Delegate& other) noexcept {
+    if (other.m_Manage)
+        other.m_Manage(Operation::Move, m_Storage, other.m_Storage);
+    else if (other.m_Invoke)
+        std::memcpy(m_Storage, other.m_Storage, Capacity);
+    m_Invoke = std::exchange(other.m_Invoke, nullptr);
+    m_Manage = std::exchange(other.m_Manage, nullptr);
+}
+
+using EventHandler = Delegate<void()>;
+using EventCondition = Delegate<bool()>;
+
+// Emitted events carry a key (usually the target entity) and a value, and count how many emissions were merged into them
+struct EventPayload {
+    EntityId entity = tnull;
+    float value = 0.0f;
+    unsigned int count = 1;
+};
+using PayloadEventHandler = Delegate<void(const EventPayload&)>;
+
 // Tags
 template<const unsigned int value>
 using Tag = std::integral_constant<const unsigned int, value>;
@@ -84,32 +296,192 @@ std::istream& operator>>(std::istream& is, Tag<value>) {
 namespace ECS {
     // Forward declarations
     class Context;
+    class CommandBuffer;
+
+    // Runs on the worker pool, so anything touching the Context must be recorded into the buffer it is given
+    using ParallelEventHandler = Delegate<void(CommandBuffer&)>;
+
+    // CPUs grouped by NUMA node. Read from /sys on Linux, a single node holding every CPU elsewhere
+    struct NumaTopology {
+        std::vector<std::vector<unsigned int>> nodeCpus;
+        static NumaTopology detect();
+        [[nodiscard]] std::size_t getNodeCount() const { return nodeCpus.size(); }
+    };
+
+    // Counts a batch of posted jobs down, so it can be waited on without a future and its shared state per job.
+    // The first exception a job throws is kept and rethrown by wait
+    class WaitGroup {
+    public:
+        void add(const unsigned int count = 1);
+        template<typename F>
+        void run(F& job);
+        void wait();
+    private:
+        std::mutex m_Mutex;
+        std::condition_variable m_Condition;
+        unsigned int m_Pending = 0;
+        std::exception_ptr m_Exception;
+    };
+
+    // One queue per NUMA node, served by workers pinned to that node's CPUs
+    class WorkerPool {
+    public:
+        explicit WorkerPool(const NumaTopology& topology = NumaTopology::detect());
+        ~WorkerPool();
+        WorkerPool(const WorkerPool&) = delete;
+        WorkerPool& operator=(const WorkerPool&) = delete;
+
+        // Allocates a packaged_task and its shared state, so it is kept for one-off jobs that return a result
+        template<typename F>
+        std::future<std::invoke_result_t<F>> submit(F&& job, unsigned int node = ANY_NUMA_NODE);
+        // Queues the job in a delegate, without allocating, and counts it in the group until it has run
+        template<typename F>
+        void post(WaitGroup& group, F&& job, unsigned int node = ANY_NUMA_NODE);
+        [[nodiscard]] std::size_t getNodeCount() const { return m_Queues.size(); }
+        [[nodiscard]] std::size_t getWorkerCount() const { return m_Workers.size(); }
+    private:
+        struct NodeQueue {
+            std::mutex mutex;
+            std::condition_variable condition;
+            // Reused once drained, so after the first few steps queueing a job doesn't allocate
+            std::vector<Delegate<void()>> jobs;
+            std::size_t next = 0;
+            bool stopping = false;
+        };
+        void workerLoop(NodeQueue& queue);
+
+        std::vector<std::unique_ptr<NodeQueue>> m_Queues;
+        std::vector<std::thread> m_Workers;
+        std::atomic<unsigned int> m_NextNode = 0;
+    };
+
+    // One bit per entity id, so sets of entities can be intersected a whole word at a time
+    class EntityBitmap {
+    public:
+        static constexpr std::size_t WORD_COUNT = (MAX_ENTITIES + 63) / 64;
+
+        void set(const EntityId entityId) { m_Words[entityId / 64] |= std::uint64_t{1} << (entityId % 64); }
+        void reset(const EntityId entityId) { m_Words[entityId / 64] &= ~(std::uint64_t{1} << (entityId % 64)); }
+        [[nodiscard]] bool test(const EntityId entityId) const { return (m_Words[entityId / 64] >> (entityId % 64)) & 1; }
+        [[nodiscard]] std::size_t count() const;
+        EntityBitmap& operator&=(const EntityBitmap& other);
+        EntityBitmap& andNot(const EntityBitmap& other);
+        EntityBitmap& operator|=(const EntityBitmap& other);
+        template<typename Function>
+        void forEach(Function&& function) const;
+    private:
+        std::array<std::uint64_t, WORD_COUNT> m_Words{};
+    };
+
+    // Double buffered storages keep a second column that readers see while writers fill in the next frame
+    enum class StorageMode {
+        Single,
+        DoubleBuffered
+    };
+
+    enum class AllocationPolicy {
+        Default,
+        HugePages // The storage's component columns are backed by huge pages where the platform allows it
+    };
+
+    template<typename T>
+    class ColumnAllocator {
+    public:
+        using value_type = T;
+        using propagate_on_container_copy_assignment = std::false_type;
+        using propagate_on_container_move_assignment = std::true_type;
+        using propagate_on_container_swap = std::true_type;
+
+        explicit ColumnAllocator(const AllocationPolicy policy = AllocationPolicy::Default) noexcept : m_Policy(policy) {}
+        template<typename U>
+        explicit ColumnAllocator(const ColumnAllocator<U>& other) noexcept : m_Policy(other.getPolicy()) {}
+        // Copies of a column, like the ones in snapshots, are read briefly and don't get huge pages of their own
+        [[nodiscard]] ColumnAllocator select_on_container_copy_construction() const noexcept { return ColumnAllocator(); }
+
+        T* allocate(std::size_t count);
+        void deallocate(T* pointer, std::size_t count) noexcept;
+        [[nodiscard]] AllocationPolicy getPolicy() const noexcept { return m_Policy; }
+
+        template<typename U>
+        bool operator==(const ColumnAllocator<U>& other) const noexcept { return m_Policy == other.getPolicy(); }
+    private:
+        [[nodiscard]] bool usesHugePages() const noexcept;
+
+        AllocationPolicy m_Policy;
+    };
 
     class IComponentStorage {
     public:
         virtual ~IComponentStorage() = default;
-        virtual void entityDestroyed(EntityId entityId) = 0;
+        // Every entity passed in is known to have the component, so there is no need to check
+        virtual void entitiesDestroyed(const EntityId* entityIds, std::size_t count) = 0;
+        virtual void swapBuffers() = 0;
+        virtual void copyInto(std::shared_ptr<IComponentStorage>& target) const = 0;
+        virtual void firstTouch() = 0;
+        [[nodiscard]] virtual std::size_t size() const = 0;
+        [[nodiscard]] virtual const EntityId* entities() const = 0; // Dense, in storage order
         virtual void dump(std::ostream& os) const = 0;
         virtual void deserialise(std::istringstream& iss, EntityId entityId) = 0;
+
+        [[nodiscard]] unsigned int getNumaNode() const { return m_NumaNode; }
+        void setNumaNode(const unsigned int node) { m_NumaNode = node; }
+
+        // Which entities have the component, kept by the storage as components are added and removed
+        [[nodiscard]] const EntityBitmap& getPresence() const { return m_Presence; }
+
+        // Change tracking for reactive events: writes are stamped with the Context's current event epoch
+        void setChangeEpoch(const std::uint32_t epoch) { m_ChangeEpoch = epoch; }
+        [[nodiscard]] bool changedSince(const std::uint32_t epoch) const { return std::atomic_ref(m_LastChange).load(std::memory_order_relaxed) >= epoch; }
+        [[nodiscard]] bool changedSince(const EntityId entityId, const std::uint32_t epoch) const { return m_ChangedAt[entityId] >= epoch; }
+    protected:
+        void markChanged(const EntityId entityId) {
+            m_ChangedAt[entityId] = m_ChangeEpoch;
+            // Systems in a pipeline can write the same storage concurrently, so only store when the epoch moves
+            if (std::atomic_ref lastChange(m_LastChange); lastChange.load(std::memory_order_relaxed) != m_ChangeEpoch)
+                lastChange.store(m_ChangeEpoch, std::memory_order_relaxed);
+        }
+
+        EntityBitmap m_Presence;
+    private:
+        unsigned int m_NumaNode = ANY_NUMA_NODE;
+        std::uint32_t m_ChangeEpoch = 1;
+        mutable std::uint32_t m_LastChange = 0;
+        std::array<std::uint32_t, MAX_ENTITIES> m_ChangedAt{};
     };
 
     template <typename T>
-    class ComponentStorage : public IComponentStorage {
+    class ComponentStorage final : public IComponentStorage {
     public:
-        explicit ComponentStorage() : m_Components(), entityToIndexMap(), indexToEntityMap(){
+        using Column = std::vector<T, ColumnAllocator<T>>;
+
+        explicit ComponentStorage(const StorageMode mode = StorageMode::Single, const AllocationPolicy policy = AllocationPolicy::Default)
+            : m_Mode(mode), m_Components(ColumnAllocator<T>(policy)), m_Previous(ColumnAllocator<T>(policy)), entityToIndexMap(), indexToEntityMap(){
             entityToIndexMap.fill(tnull);
             indexToEntityMap.fill(tnull);
         }
-        void entityDestroyed(const EntityId entityId) override;
+        void entitiesDestroyed(const EntityId* entityIds, const std::size_t count) override;
+        void swapBuffers() override;
+        void copyInto(std::shared_ptr<IComponentStorage>& target) const override;
+        void firstTouch() override;
+        [[nodiscard]] std::size_t size() const override { return m_Components.size(); }
+        [[nodiscard]] const EntityId* entities() const override { return indexToEntityMap.data(); }
         void add(const EntityId entityId, T& component);
         void remove(const EntityId entityId);
         T& get(const EntityId entityId);
+        T& modify(const EntityId entityId); // Like get, but stamped as a write for change tracking
+        const T& get(const EntityId entityId) const;
+        const T& getPrevious(const EntityId entityId) const;
         [[nodiscard]] bool has(const EntityId entityId) const;
+        [[nodiscard]] bool isDoubleBuffered() const { return m_Mode == StorageMode::DoubleBuffered; }
+        [[nodiscard]] const T* data() const { return m_Components.data(); } // Dense, in the same order as entities()
         void dump(std::ostream& os) const override;
         void deserialise(std::istringstream& iss, const EntityId entityId) override;
 
     private:
-        std::vector<T> m_Components;
+        StorageMode m_Mode;
+        Column m_Components; // Written this frame
+        Column m_Previous; // Published at the last pipeline barrier (double buffered only)
+        bool m_Unpublished = false; // A mutable reference was handed out since the last barrier (double buffered only)
         std::array<unsigned int, MAX_ENTITIES> entityToIndexMap;
         std::array<EntityId, MAX_ENTITIES> indexToEntityMap;
     };
@@ -121,18 +493,362 @@ namespace ECS {
         [[nodiscard]] std::unordered_set<EntityId>& getEntities() { return m_Entities; }
         virtual void update() = 0;
         virtual ~System() = default;
+
+        // Tick rate: runs on every interval-th simulation tick, offset by phase. An interval of 0 runs once per frame instead.
+        void setTickRate(const unsigned int interval, const unsigned int phase = 0) { m_TickInterval = interval; m_TickPhase = phase; }
+        [[nodiscard]] unsigned int getTickInterval() const { return m_TickInterval; }
+        [[nodiscard]] unsigned int getTickPhase() const { return m_TickPhase; }
+        [[nodiscard]] bool isDueOnTick(const std::uint64_t tick) const { return m_TickInterval != 0 && tick % m_TickInterval == m_TickPhase % m_TickInterval; }
+        [[nodiscard]] bool isFrameSystem() const { return m_TickInterval == 0; }
+
+        // The NUMA node whose workers run this system
+        [[nodiscard]] unsigned int getNumaNode() const { return m_NumaNode; }
+        void setNumaNode(const unsigned int node) { m_NumaNode = node; }
+
+        // Membership changes go through these so derived systems can keep their own bookkeeping in sync
+        virtual bool insertEntity(const EntityId entityId) { return m_Entities.insert(entityId).second; }
+        virtual bool eraseEntity(const EntityId entityId) { return m_Entities.erase(entityId) != 0; }
+        // m_Entities still holds disabled entities, updates over it should skip those this returns false for
+        [[nodiscard]] bool isEnabled(const EntityId entityId) const;
+        // Calls function(entityId) for every entity in m_Entities that is enabled
+        template<typename Function>
+        void forEachEnabled(Function&& function) const;
+
+        // Loop fusion (see Context::setSystemFusion). A fusable system can run its per-entity body over any block of its entities
+        [[nodiscard]] virtual bool isFusable() const { return false; }
+        [[nodiscard]] virtual Signature getWriteSignature() const { return m_Signature; }
+        [[nodiscard]] virtual std::span<const EntityId> getDenseEntities() const { return {}; }
+        virtual void updateEntities(std::span<const EntityId>) {}
     protected:
         Context& m_Context;
         const Signature m_Signature;
         std::unordered_set<EntityId> m_Entities;
+    private:
+        unsigned int m_TickInterval = 1;
+        unsigned int m_TickPhase = 0;
+        unsigned int m_NumaNode = ANY_NUMA_NODE;
+    };
+
+    struct AmortisedStats {
+        std::size_t pending = 0; // Entities not yet visited in the current sweep
+        std::size_t processedLastUpdate = 0;
+        std::uint64_t completedSweeps = 0;
+        unsigned int updatesInCurrentSweep = 0;
+        unsigned int updatesForLastSweep = 0; // How stale an entity can get before it is visited again
+    };
+
+    // Processes a rotating slice of its entities each update, limited by an entity count and/or time budget
+    class AmortisedSystem : public System {
+    public:
+        AmortisedSystem(Context& context, const Signature signature, const std::size_t entityBudget) : System(context, signature), m_EntityBudget(entityBudget) {
+            m_OrderIndices.fill(tnull);
+        }
+        void setEntityBudget(const std::size_t entityBudget) { m_EntityBudget = entityBudget; }
+        void setTimeBudget(const std::chrono::microseconds timeBudget) { m_TimeBudget = timeBudget; }
+        [[nodiscard]] const AmortisedStats& getStats() const { return m_Stats; }
+
+        void update() final;
+        virtual void updateEntity(EntityId entityId) = 0;
+
+        bool insertEntity(const EntityId entityId) override;
+        bool eraseEntity(const EntityId entityId) override;
+    private:
+        void swapOrder(const std::size_t a, const std::size_t b);
+
+        std::size_t m_EntityBudget;
+        std::chrono::microseconds m_TimeBudget = std::chrono::microseconds::zero(); // Zero means no time limit
+        // [0, m_Cursor) has been visited this sweep, [m_Cursor, end) is still pending
+        std::vector<EntityId> m_Order;
+        std::array<unsigned int, MAX_ENTITIES> m_OrderIndices;
+        std::size_t m_Cursor = 0;
+        AmortisedStats m_Stats;
+    };
+
+    // Component access declarations for TypedSystem. Reads don't count as writes for change tracking,
+    // and on a double buffered storage they see last step's published values, like getPreviousComponent
+    template<typename T>
+    struct Write {
+        using Type = T;
+        static constexpr bool WRITES = true;
+        static T& get(ComponentStorage<T>& storage, const EntityId entityId) { return storage.modify(entityId); }
+    };
+
+    template<typename T>
+    struct Read {
+        using Type = T;
+        static constexpr bool WRITES = false;
+        static const T& get(const ComponentStorage<T>& storage, const EntityId entityId) { return storage.getPrevious(entityId); }
+    };
+
+    // A system declared by its component access, e.g. TypedSystem<MovementSystem, Write<Position>, Read<Velocity>>.
+    // The signature comes from the declarations, and Derived::updateEntity(entityId, Position&, const Velocity&) is
+    // called from a loop over storage pointers resolved once per update, so it can be inlined.
+    // updateEntity must only touch the entity it is given, which is what lets typed systems be fused.
+    template<typename Derived, typename... Accesses>
+    class TypedSystem : public System {
+    public:
+        explicit TypedSystem(Context& context);
+        void update() final;
+
+        bool insertEntity(const EntityId entityId) override;
+        bool eraseEntity(const EntityId entityId) override;
+
+        [[nodiscard]] bool isFusable() const override { return true; }
+        [[nodiscard]] Signature getWriteSignature() const override { return m_WriteSignature; }
+        [[nodiscard]] std::span<const EntityId> getDenseEntities() const override { return m_Dense; }
+        void updateEntities(std::span<const EntityId> entityIds) final;
+    private:
+        static Signature createSignature(Context& context);
+        template<std::size_t... Indices>
+        void run(std::span<const EntityId> entityIds, std::index_sequence<Indices...>);
+
+        Signature m_WriteSignature;
+
+        // Dense copy of m_Entities, so the loop doesn't walk the hash set
+        std::vector<EntityId> m_Dense;
+        std::array<unsigned int, MAX_ENTITIES> m_DenseIndices;
+    };
+
+    // A read only copy of the components the extraction systems declared, taken at the end of a frame
+    class FrameSnapshot {
+    public:
+        template<typename T>
+        const T& getComponent(const EntityId entityId) const;
+        template<typename T>
+        [[nodiscard]] bool hasComponent(const EntityId entityId) const;
+        template<typename T>
+        const ComponentStorage<T>& getStorage() const;
+        [[nodiscard]] bool isAlive(const EntityId entityId) const { return m_AliveEntities.test(entityId); }
+        [[nodiscard]] const Signature& getSignature(const EntityId entityId) const { return m_EntitySignatures[entityId]; }
+        [[nodiscard]] std::uint64_t getTick() const { return m_Tick; }
+    private:
+        friend class Context;
+        template<typename T>
+        [[nodiscard]] ComponentTypeId getComponentTypeId() const;
+
+        // Copied from the Context when the snapshot is taken, so extraction workers never look anything up in the live Context
+        std::vector<ComponentTypeId> m_ComponentTypeIds;
+        std::array<std::shared_ptr<IComponentStorage>, MAX_COMPONENTS> m_ComponentStorages;
+        std::array<Signature, MAX_ENTITIES> m_EntitySignatures;
+        EntityBitmap m_AliveEntities;
+        std::uint64_t m_Tick = 0;
+    };
+
+    // Runs over a FrameSnapshot while the next frame simulates, so it must not touch the Context's components directly
+    class ExtractionSystem {
+    public:
+        ExtractionSystem(Context& context, const Signature signature) : m_Context(context), m_Signature(signature) {}
+        [[nodiscard]] Signature getSignature() const { return m_Signature; }
+        [[nodiscard]] std::vector<EntityId>& getEntities() { return m_Entities; }
+        virtual void extract(const FrameSnapshot& snapshot) = 0;
+        virtual ~ExtractionSystem() = default;
+    protected:
+        Context& m_Context;
+        const Signature m_Signature;
+        std::vector<EntityId> m_Entities; // Entities matching the signature when the snapshot was taken
+    };
+
+    // Lock free stack of freed entity ids, linked through an array indexed by id. The head carries a tag to guard against ABA
+    class FreedEntityStack {
+    public:
+        void push(const EntityId entityId);
+        EntityId pop(); // tnull when empty
+        [[nodiscard]] std::vector<EntityId> toVector() const; // Bottom to top, only safe while no other thread is using the stack
+    private:
+        std::array<std::atomic<EntityId>, MAX_ENTITIES> m_Links{};
+        std::atomic<std::uint64_t> m_Head = tnull;
+    };
+
+    // How the entities matching an include and exclude mask will be found, chosen from the live storage sizes
+    struct QueryPlan {
+        enum class Strategy {
+            Bitmap, // Intersect every storage's presence bitmap
+            Drive   // Walk the smallest included storage and test the other bitmaps per entity
+        };
+        struct Step {
+            ComponentTypeId typeId;
+            const char* typeName;
+            std::size_t size;
+        };
+
+        Strategy strategy = Strategy::Bitmap;
+        Step driving{}; // Only meaningful for Drive
+        std::vector<Step> includeChecks; // Most selective first
+        std::vector<Step> excludeChecks; // Most likely to reject first
+        double estimatedMatches = 0.0;
+        double estimatedCost = 0.0;
+
+        void explain(std::ostream& os) const;
+    };
+
+    // The entities matching an include and an exclude mask, kept up to date by the Context as components are added and removed.
+    // Matching ignores the enabled bits, so iterate with forEachEnabled to skip disabled entities
+    class Query {
+    public:
+        Query(const Signature include, const Signature exclude) : m_Include(include), m_Exclude(exclude) { m_Indices.fill(tnull); }
+        [[nodiscard]] bool matches(const Signature& signature) const { return (signature & m_Include) == m_Include && (signature & m_Exclude).none(); }
+        [[nodiscard]] Signature getInclude() const { return m_Include; }
+        [[nodiscard]] Signature getExclude() const { return m_Exclude; }
+        [[nodiscard]] bool contains(const EntityId entityId) const { return m_Indices[entityId] != tnull; }
+        [[nodiscard]] std::size_t size() const { return m_Entities.size(); }
+        [[nodiscard]] const std::vector<EntityId>& getEntities() const { return m_Entities; }
+        [[nodiscard]] std::vector<EntityId>::const_iterator begin() const { return m_Entities.begin(); }
+        [[nodiscard]] std::vector<EntityId>::const_iterator end() const { return m_Entities.end(); }
+        // Calls function(entityId) for every matching entity with the included components enabled
+        template<typename Function>
+        void forEachEnabled(const Context& context, Function&& function) const;
+    private:
+        friend class Context;
+        void refresh(const EntityId entityId, const Signature& signature);
+        void erase(const EntityId entityId);
+
+        const Signature m_Include;
+        const Signature m_Exclude;
+        std::vector<EntityId> m_Entities;
+        std::array<unsigned int, MAX_ENTITIES> m_Indices;
+    };
+
+    // Hierarchical timing wheel: scheduling and cancelling are O(1), and advancing only touches the timers that are due
+    // (plus the occasional cascade of a coarser slot into the finer levels)
+    class TimingWheel {
+    public:
+        static constexpr unsigned int LEVEL_BITS = 6;
+        static constexpr unsigned int SLOT_COUNT = 1u << LEVEL_BITS;
+        static constexpr unsigned int LEVEL_COUNT = 4; // Covers 2^24 ticks, anything further out waits in an overflow list
+
+        TimingWheel() { m_Heads.fill(NIL); }
+        TimerId schedule(std::uint64_t expiry, TimerCallback callback); // Fires when the wheel reaches expiry, or the next tick if that has passed
+        bool cancel(const TimerId timerId);
+        void advanceTo(const std::uint64_t tick);
+        [[nodiscard]] std::uint64_t now() const { return m_Now; }
+        [[nodiscard]] std::size_t size() const { return m_Timers.size() - m_FreeTimers.size(); }
+    private:
+        static constexpr unsigned int NIL = std::numeric_limits<unsigned int>::max();
+        static constexpr unsigned int OVERFLOW_LIST = LEVEL_COUNT * SLOT_COUNT;
+
+        struct Timer {
+            std::uint64_t expiry = 0;
+            TimerCallback callback;
+            unsigned int generation = 0;
+            unsigned int list = NIL;
+            unsigned int prev = NIL;
+            unsigned int next = NIL;
+        };
+
+        void insert(const unsigned int index);
+        void link(const unsigned int index, const unsigned int list);
+        void unlink(const unsigned int index);
+        void advance();
+
+        std::vector<Timer> m_Timers;
+        std::vector<unsigned int> m_FreeTimers;
+        std::array<unsigned int, OVERFLOW_LIST + 1> m_Heads;
+        std::uint64_t m_Now = 0;
+    };
+
+    // How emissions of the same event with the same key are merged before dispatch
+    enum class CoalescePolicy {
+        None,       // Every emission is dispatched
+        KeepFirst,  // One dispatch per key with the first emitted value
+        KeepLatest, // One dispatch per key with the last emitted value
+        Accumulate  // One dispatch per key with the values summed
+    };
+
+    struct EventChannel {
+        EventId eventId;
+        unsigned int lane = 0; // Lower lanes are dispatched first
+        CoalescePolicy policy = CoalescePolicy::None;
+        EventCondition condition;
+        // Reactive conditions are only re-evaluated once a dependency changed, otherwise the last result is reused
+        Signature dependencies;
+        std::vector<EntityId> watchedEntities; // Empty means any entity
+        std::uint32_t evaluatedEpoch = 0;
+        bool lastResult = false;
+        bool threadSafe = false; // The condition may be evaluated on the worker pool alongside others
+        std::vector<EventHandler> handlers;
+        std::vector<ParallelEventHandler> parallelHandlers;
+        std::vector<PayloadEventHandler> payloadHandlers;
+        std::vector<EventPayload> pending; // Already coalesced, in order of each key's first emission
+        std::unordered_map<EntityId, std::size_t> pendingIndices;
+    };
+
+    // Records structural changes from any thread and applies them in order when flushed by the Context
+    class CommandBuffer {
+    public:
+        template<typename T>
+        void addComponent(const EntityId entityId, T component);
+        template<typename T>
+        void removeComponent(const EntityId entityId);
+        void destroyEntity(const EntityId entityId);
+        void push(std::function<void(Context&)> command);
+        void flush(Context& context);
+    private:
+        std::mutex m_Mutex;
+        std::vector<std::function<void(Context&)>> m_Commands;
+    };
+
+    // A coroutine owned and resumed by the Context, so long running work can be spread across frames
+    class Task {
+    public:
+        struct promise_type {
+            std::exception_ptr exception;
+            Task get_return_object() { return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+            std::suspend_always initial_suspend() noexcept { return {}; } // Started by Context::spawn
+            std::suspend_always final_suspend() noexcept { return {}; } // Destroyed by the Context once done
+            void return_void() {}
+            void unhandled_exception() { exception = std::current_exception(); }
+        };
+
+        Task(Task&& other) noexcept : m_Handle(std::exchange(other.m_Handle, {})) {}
+        Task& operator=(Task&& other) noexcept;
+        Task(const Task&) = delete;
+        Task& operator=(const Task&) = delete;
+        ~Task() { if (m_Handle) m_Handle.destroy(); }
+        [[nodiscard]] bool done() const { return !m_Handle || m_Handle.done(); }
+    private:
+        friend class Context;
+        explicit Task(const std::coroutine_handle<promise_type> handle) : m_Handle(handle) {}
+        std::coroutine_handle<promise_type> m_Handle;
+    };
+
+    // co_await context.nextFrame() resumes at the start of the next simulation step
+    struct NextFrameAwaiter {
+        Context& m_Context;
+        [[nodiscard]] bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle) const;
+        void await_resume() const noexcept {}
+    };
+
+    // co_await context.afterPipeline(i) resumes once pipeline i has finished (and its buffers have been swapped)
+    struct PipelineAwaiter {
+        Context& m_Context;
+        unsigned int m_PipelineIndex;
+        [[nodiscard]] bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle) const;
+        void await_resume() const noexcept {}
+    };
+
+    // co_await context.runJob(fn) runs fn off the main thread and resumes with its result at the start of the first step after it finishes
+    template<typename R>
+    struct JobAwaiter {
+        Context& m_Context;
+        std::future<R> m_Future;
+        [[nodiscard]] bool await_ready() const { return m_Future.wait_for(std::chrono::seconds::zero()) == std::future_status::ready; }
+        void await_suspend(std::coroutine_handle<> handle);
+        R await_resume() { return m_Future.get(); }
     };
 
     class SystemPipeline {
     public:
         SystemPipeline() = default;
         void addSystem(const std::shared_ptr<System>& system) { m_Systems.push_back(system); }
-        void update() const;
+        [[nodiscard]] const std::vector<std::shared_ptr<System>>& getSystems() const { return m_Systems; }
+        bool update(WorkerPool& pool, const std::uint64_t tick) const;
+        bool updateFrame(WorkerPool& pool) const;
     private:
+        template<typename Predicate>
+        bool run(WorkerPool& pool, Predicate predicate) const;
+
         std::vector<std::shared_ptr<System>> m_Systems;
     };
 
@@ -142,12 +858,15 @@ namespace ECS {
 
         // Entity methods
         EntityId createEntity();
+        EntityId createEntityDeferred();
         void addEntity(const EntityId entityId);
         void destroyEntity(const EntityId entityId);
+        void destroyEntities(const std::vector<EntityId>& entityIds);
+        [[nodiscard]] bool isAlive(const EntityId entityId) const { return entityId < MAX_ENTITIES && m_EntityIndices[entityId] != tnull; }
 
         // Component methods
         template<typename T>
-        void registerComponentType();
+        void registerComponentType(const StorageMode mode = StorageMode::Single, const AllocationPolicy policy = AllocationPolicy::Default);
         template<typename T>
         void addComponent(const EntityId entityId, T component);
         template<typename T>
@@ -155,252 +874,2930 @@ namespace ECS {
         template<typename T>
         T& getComponent(const EntityId entityId);
         template<typename T>
+        T& modifyComponent(const EntityId entityId);
+        template<typename T>
+        const T& readComponent(const EntityId entityId);
+        template<typename T>
+        const T& getPreviousComponent(const EntityId entityId);
+        template<typename T>
         bool hasComponent(const EntityId entityId);
         template<typename T>
-        ComponentTypeId getComponentTypeId();
+        ComponentTypeId getComponentTypeId() const;
+        template<typename T>
+        [[nodiscard]] bool isComponentRegistered() const;
+        template<typename... Components>
+        Signature createSignature();
         template<typename T>
         std::shared_ptr<ComponentStorage<T>> getComponentStorage();
+        template<typename T>
+        void placeComponentStorage(const unsigned int node);
+
+        // Enable methods. Disabled entities, and entities with a disabled component in the signature, are skipped by views and systems.
+        // Toggling only flips bits: nothing moves in the storages and no system or query is told
+        void setEntityEnabled(const EntityId entityId, const bool enabled);
+        [[nodiscard]] bool isEntityEnabled(const EntityId entityId) const { return !m_DisabledEntities.test(entityId); }
+        template<typename T>
+        void setComponentEnabled(const EntityId entityId, const bool enabled);
+        template<typename T>
+        [[nodiscard]] bool isComponentEnabled(const EntityId entityId) const { return !m_DisabledComponents[entityId][getComponentTypeId<T>()]; }
+        [[nodiscard]] bool isEnabledFor(const EntityId entityId, const Signature& signature) const;
+        [[nodiscard]] bool hasDisabled() const { return m_DisabledCount != 0; }
+
+        // Query methods
+        std::shared_ptr<Query> addQuery(const Signature& include, const Signature& exclude = Signature());
+        void removeQuery(const std::shared_ptr<Query>& query);
+        void collectEntities(const Signature& include, const Signature& exclude, std::vector<EntityId>& entityIds) const;
+        [[nodiscard]] QueryPlan planQuery(const Signature& include, const Signature& exclude = Signature()) const;
+        // Components the function takes by mutable reference are recorded as changed, so it should spell out its parameter types
+        template<typename... Components, typename Function>
+        void view(Function&& function);
 
         // System methods
         void addSystem(const std::shared_ptr<System>& system, unsigned int pipelineIndex = 0);
-        void update() const;
+        void update();
+        // Runs consecutive pipelines that each hold one fusable system over the same signature as a single entity loop
+        void setSystemFusion(const bool enabled) { m_SystemFusion = enabled; }
+
+        // Scheduling methods
+        void setFixedTimestep(const float timestep, const unsigned int maxSubsteps = 8);
+        // The rate is kept, so the system's tick interval follows later timestep changes
+        void setSystemUpdateRate(const std::shared_ptr<System>& system, const float rate);
+        unsigned int tick(const float frameTime);
+        [[nodiscard]] float getInterpolationAlpha() const { return m_Accumulator / m_FixedTimestep; }
+        [[nodiscard]] std::uint64_t getTick() const { return m_Tick; }
+
+        // Timer methods (delays are in simulation steps, and a timer fires at the start of the step it is due on)
+        TimerId scheduleTimer(const std::uint64_t delay, TimerCallback callback);
+        template<typename T>
+        TimerId scheduleComponent(const std::uint64_t delay, const EntityId entityId, T component);
+        bool cancelTimer(const TimerId timerId) { return m_TimingWheel.cancel(timerId); }
+
+        // Task methods
+        void spawn(Task task);
+        NextFrameAwaiter nextFrame() { return NextFrameAwaiter{*this}; }
+        PipelineAwaiter afterPipeline(const unsigned int pipelineIndex) { return PipelineAwaiter{*this, pipelineIndex}; }
+        template<typename F>
+        JobAwaiter<std::invoke_result_t<F>> runJob(F&& job);
+        CommandBuffer& getCommandBuffer() { return m_CommandBuffer; }
+        void flushCommands() { m_CommandBuffer.flush(*this); }
+        WorkerPool& getWorkerPool();
+
+        // Extraction methods
+        void addExtractionSystem(const std::shared_ptr<ExtractionSystem>& system);
+        void extract();
+        void waitForExtraction();
 
         // Event handling methods
         void addEvent(const EventId eventId, const EventCondition& eventCondition);
+        void addEvent(const EventId eventId, const EventCondition& eventCondition, const Signature& dependencies, const std::vector<EntityId>& watchedEntities = {});
         void addEventHandler(const EventId eventId, const EventHandler& eventHandler);
+        void addEventHandler(const EventId eventId, const PayloadEventHandler& eventHandler);
+        void addEventHandler(const EventId eventId, const ParallelEventHandler& eventHandler);
+        void setEventThreadSafe(const EventId eventId, const bool threadSafe = true);
+        void setEventPolicy(const EventId eventId, const CoalescePolicy policy, const unsigned int lane = 0);
+        void emitEvent(const EventId eventId, const EventPayload& payload = EventPayload());
         void updateEvents();
 
-        // Serialisation methods
-        friend std::ostream& operator<<(std::ostream& os, const Context& context);
-        friend std::istream& operator>>(std::istream& is, Context& context);
+        // Serialisation methods
+        friend std::ostream& operator<<(std::ostream& os, const Context& context);
+        friend std::istream& operator>>(std::istream& is, Context& context);
+
+        // Finishes extraction and the worker pool's jobs before any member they could touch is destroyed
+        ~Context();
+
+    private:
+        std::vector<EntityId> m_EntityList;
+        FreedEntityStack m_FreedEntityList;
+        std::array<unsigned int, MAX_ENTITIES> m_EntityIndices;
+        EntityBitmap m_AliveEntities;
+        std::atomic<EntityId> nextEntityId = 0;
+        const std::uint64_t m_Serial = nextContextSerial(); // Tells thread local id reservations of different contexts apart
+        static std::uint64_t nextContextSerial();
+        EntityId reserveEntityId();
+        std::pair<EntityId, EntityId> claimFreshIds(const EntityId count);
+        void returnReservedIds();
+
+        // A batch of fresh ids claimed by one thread. next and end are only touched while holding busy: by the owner while it
+        // reserves, and by returnReservedIds while it hands the batch back at the end of a step
+        struct alignas(64) IdReservation {
+            std::atomic<std::thread::id> owner{};
+            std::atomic<bool> busy = false;
+            EntityId next = 0;
+            EntityId end = 0;
+        };
+        std::array<IdReservation, ENTITY_RESERVATION_SLOTS> m_IdReservations;
+
+        std::array<Signature, MAX_ENTITIES> m_EntitySignatures;
+        std::array<std::vector<EntityId>, MAX_COMPONENTS> m_DestroyBatches; // Kept around so batched destruction doesn't allocate
+        bool releaseEntity(const EntityId entityId);
+
+        std::array<std::shared_ptr<IComponentStorage>, MAX_COMPONENTS> m_ComponentStorages;
+        std::vector<std::shared_ptr<IComponentStorage>> m_DoubleBufferedStorages;
+        Signature m_DoubleBufferedTypes; // Systems over these aren't fused, as a chain publishes them only once at its end
+        ComponentTypeId nextComponentTypeId = 0;
+        std::map<const char*, ComponentTypeId > m_ComponentTypes;
+        std::vector<ComponentTypeId> m_ComponentTypeIds; // By TypeIndex, grown at registration, MAX_COMPONENTS if unregistered
+        // By TypeIndex of the component list, 0 until first built. Systems build signatures concurrently, so slots are atomic
+        std::array<std::atomic<std::uint64_t>, SIGNATURE_CACHE_SIZE> m_SignatureCache{};
+        std::array<const char*, MAX_COMPONENTS> m_ComponentTypeNames{};
+
+        // Disabled components are kept both per entity and per type, for single checks and for bitmap filtering
+        EntityBitmap m_DisabledEntities;
+        std::array<Signature, MAX_ENTITIES> m_DisabledComponents;
+        std::array<EntityBitmap, MAX_COMPONENTS> m_DisabledComponentBitmaps;
+        std::size_t m_DisabledCount = 0; // Disabled entities plus disabled components, so the common case skips filtering
+        void setComponentEnabled(const EntityId entityId, const ComponentTypeId typeId, const bool enabled);
+
+        std::vector<std::shared_ptr<System>> m_Systems;
+        std::vector<std::shared_ptr<SystemPipeline>> m_SystemPipelines;
+        std::vector<std::shared_ptr<Query>> m_Queries;
+        std::unique_ptr<WorkerPool> m_WorkerPool; // Created on first use
+
+        float m_FixedTimestep = 1.0f / 60.0f;
+        unsigned int m_MaxSubsteps = 8;
+        float m_Accumulator = 0.0f;
+        std::uint64_t m_Tick = 0;
+        std::vector<std::pair<std::shared_ptr<System>, float>> m_SystemUpdateRates; // In the order they were first set, so phases are stable
+        void applySystemUpdateRates();
+
+        void runStep();
+        void runFrame();
+        [[nodiscard]] std::size_t findFusedChain(const std::size_t firstPipeline) const;
+        void runFusedChain(const std::size_t firstPipeline, const std::size_t endPipeline);
+        bool m_SystemFusion = false;
+        std::vector<System*> m_FusedSystems; // Kept around so fusing doesn't allocate every tick
+        void swapBuffers() const;
+
+        std::vector<std::shared_ptr<ExtractionSystem>> m_ExtractionSystems;
+        Signature m_ExtractionSignature;
+        FrameSnapshot m_Snapshot;
+        WaitGroup m_ExtractionGroup; // Waited on by the caller's thread, so extraction never ties up a worker or a thread of its own
+
+        friend struct NextFrameAwaiter;
+        friend struct PipelineAwaiter;
+        template<typename R>
+        friend struct JobAwaiter;
+
+        CommandBuffer m_CommandBuffer;
+        TimingWheel m_TimingWheel;
+        std::vector<Task> m_Tasks;
+        std::vector<std::coroutine_handle<>> m_NextFrameWaiters;
+        std::vector<std::vector<std::coroutine_handle<>>> m_PipelineWaiters;
+        std::vector<std::pair<std::function<bool()>, std::coroutine_handle<>>> m_JobWaiters;
+
+        void resumeFrameWaiters();
+        void resumePipelineWaiters(const std::size_t pipelineIndex);
+        void reapTasks();
+
+        // Channels are dispatched by lane, then in the order they were first used
+        std::mutex m_EventMutex;
+        std::vector<EventChannel> m_EventChannels;
+        std::unordered_map<EventId, std::size_t> m_EventChannelIndices;
+        std::vector<std::size_t> m_EventDispatchOrder;
+        bool m_EventDispatchOrderDirty = false;
+
+        // Stamped on component writes. Advanced by updateEvents and by replication, so each can ask what changed since it last looked
+        std::uint32_t m_ChangeEpoch = 1;
+        std::uint32_t advanceChangeEpoch();
+        friend class Replicator;
+
+        std::vector<std::size_t> m_ThreadSafeEvents;
+        std::vector<std::pair<std::size_t, std::size_t>> m_FiredParallelHandlers; // Channel and handler indices
+        std::vector<std::unique_ptr<CommandBuffer>> m_EventCommandBuffers; // One per fired parallel handler, reused
+
+        EventChannel& getEventChannel(const EventId eventId);
+        bool evaluateEventCondition(EventChannel& channel);
+        template<typename F>
+        void forEachEventBatch(const std::size_t count, F&& function);
+
+        // Whether a view function needs the component at Index by mutable reference, in which case the view counts it as written
+        template<typename Function, std::size_t Index, typename... Components, std::size_t... Indices>
+        static constexpr bool viewWrites(std::index_sequence<Indices...>) {
+            return !std::is_invocable_v<Function, EntityId, std::conditional_t<Indices == Index, const Components&, Components&>...>;
+        }
+        template<bool WRITES, typename T>
+        static std::conditional_t<WRITES, T&, const T&> getViewComponent(ComponentStorage<T>& storage, const EntityId entityId) {
+            if constexpr (WRITES)
+                return storage.modify(entityId);
+            else
+                return std::as_const(storage).get(entityId);
+        }
+    };
+
+    // Packs values into a byte buffer least significant bit first
+    class BitWriter {
+    public:
+        explicit BitWriter(std::vector<std::uint8_t>& buffer) : m_Buffer(buffer) {}
+        void write(std::uint32_t value, unsigned int bits);
+        void writeBool(const bool value) { write(value, 1); }
+        void writeFloat(const float value) { write(std::bit_cast<std::uint32_t>(value), 32); }
+        void writeSigned(std::int32_t value, unsigned int bits); // Clamped to what fits, zigzag encoded so small magnitudes stay small
+        void writeQuantised(float value, float min, float max, unsigned int bits); // Clamped to [min, max]
+        void flush(); // Pads the last partial byte
+    private:
+        std::vector<std::uint8_t>& m_Buffer;
+        std::uint64_t m_Scratch = 0;
+        unsigned int m_ScratchBits = 0;
+    };
+
+    // Reading past the end returns zeros and marks the reader as overflowed rather than asserting, since packets come off the network
+    class BitReader {
+    public:
+        BitReader(const std::uint8_t* data, const std::size_t size) : m_Data(data), m_Size(size) {}
+        std::uint32_t read(unsigned int bits);
+        bool readBool() { return read(1) != 0; }
+        float readFloat() { return std::bit_cast<float>(read(32)); }
+        std::int32_t readSigned(unsigned int bits);
+        float readQuantised(float min, float max, unsigned int bits);
+        [[nodiscard]] bool overflowed() const { return m_Overflowed; }
+    private:
+        const std::uint8_t* m_Data;
+        std::size_t m_Size;
+        std::size_t m_Position = 0;
+        std::uint64_t m_Scratch = 0;
+        unsigned int m_ScratchBits = 0;
+        bool m_Overflowed = false;
+    };
+
+    struct ReplicationStats {
+        std::size_t bytes = 0; // Of the last packet
+        std::size_t entities = 0; // Written to the last packet
+        std::size_t relevant = 0; // Entities in the client's view, or every entity without one
+        std::chrono::microseconds encodeTime{0};
+        std::size_t inFlight = 0; // Packets sent but not yet acknowledged
+    };
+
+    // Sends each client only the components that changed since the last packet it acknowledged.
+    // The server and every replica construct one, and register the same types in the same order.
+    class Replicator {
+    public:
+        static constexpr unsigned int ENTITY_ID_BITS = std::bit_width(MAX_ENTITIES);
+
+        explicit Replicator(Context& context) : m_Context(context) {}
+
+        template<typename T>
+        void replicate(void (*encode)(BitWriter&, const T&), void (*decode)(BitReader&, T&));
+
+        // Interest management: clients with a view only receive entities within its radius, plus entities without the spatial component
+        template<typename T>
+        void setSpatialComponent(float T::* x, float T::* y, const float cellSize);
+        void setClientView(const ClientId clientId, const float x, const float y, const float radius);
+        void clearClientView(const ClientId clientId);
+
+        // Server side, called between updates
+        ClientId addClient();
+        void removeClient(const ClientId clientId);
+        std::uint32_t encode(const ClientId clientId, std::vector<std::uint8_t>& packet);
+        void acknowledge(const ClientId clientId, const std::uint32_t sequence);
+        [[nodiscard]] const ReplicationStats& getStats(const ClientId clientId) const { return m_Clients[clientId].stats; }
+
+        // Replica side. Returns false for packets older than one already applied, and for truncated ones.
+        // Replica contexts are written by apply only, since entities are recreated under the server's ids.
+        bool apply(const std::vector<std::uint8_t>& packet, std::uint32_t& sequence);
+
+    private:
+        struct ReplicatedType {
+            ComponentTypeId typeId;
+            Delegate<void(BitWriter&, EntityId)> encode;
+            Delegate<void(BitReader&, EntityId)> decode; // Into the staged values, starting from the replica's current one
+            Delegate<void(EntityId)> commit; // Writes the next staged value
+            Delegate<void(EntityId)> remove;
+            Delegate<void()> clear;
+        };
+
+        // Values decoded from a packet, held until the whole packet is known to be valid
+        template<typename T>
+        struct StagedValues {
+            std::vector<T> values;
+            std::size_t next = 0;
+        };
+
+        enum class StagedKind : std::uint8_t { Destroy, Spawn, Set, Remove };
+        struct StagedChange {
+            StagedKind kind;
+            std::uint8_t type; // Index into m_Types for Set and Remove
+            EntityId entityId;
+        };
+
+        struct Client {
+            bool connected = true;
+            std::uint32_t nextSequence = 0;
+            std::uint32_t baselineEpoch = 0; // Change epoch of the newest acknowledged packet, 0 sends full state
+            std::deque<std::pair<std::uint32_t, std::uint32_t>> inFlight; // Sequence and change epoch of each unacknowledged packet
+            ReplicationStats stats;
+
+            bool hasView = false;
+            float viewX = 0.0f, viewY = 0.0f, viewRadius = 0.0f;
+            EntityBitmap relevant; // As of the last packet
+            EntityBitmap leaving; // Despawned, but not yet acknowledged
+            std::array<std::uint32_t, MAX_ENTITIES> relevanceChangedAt{}; // Epoch of the packet an entity entered or left the view in
+        };
+
+        Context& m_Context;
+        std::vector<ReplicatedType> m_Types;
+        std::vector<std::shared_ptr<void>> m_StagedValues; // A StagedValues<T> per replicated type
+        std::vector<StagedChange> m_StagedChanges;
+        std::vector<Client> m_Clients;
+        std::uint32_t m_LastApplied = 0;
+        bool m_HasApplied = false;
+
+        // A uniform grid over the spatial component, updated from the change stamps of entities that moved
+        IComponentStorage* m_SpatialStorage = nullptr;
+        Delegate<void(EntityId, float&, float&)> m_Locate;
+        float m_CellSize = 0.0f;
+        std::uint32_t m_GridEpoch = 0;
+        std::unordered_map<std::uint64_t, std::vector<EntityId>> m_Cells;
+        std::array<std::uint64_t, MAX_ENTITIES> m_EntityCells{};
+        EntityBitmap m_InGrid;
+
+        [[nodiscard]] std::uint64_t getCellKey(float x, float y) const;
+        void refreshGrid(const std::uint32_t epoch);
+        void collectRelevant(const Client& client, EntityBitmap& relevant);
+    };
+
+    // Delivers packets in memory, for running a server and its replicas in one process
+    class LoopbackTransport {
+    public:
+        void send(std::vector<std::uint8_t> packet) { m_Packets.push_back(std::move(packet)); }
+        bool receive(std::vector<std::uint8_t>& packet);
+        [[nodiscard]] std::size_t size() const { return m_Packets.size(); }
+    private:
+        std::deque<std::vector<std::uint8_t>> m_Packets;
+    };
+
+    // Layout of a shared world segment: this header, the entity table, then each column's entity ids and components.
+    // Offsets are from the start of the segment. The sequence is odd while a frame is being written (a seqlock).
+    struct SharedEntity {
+        EntityId entityId;
+        std::uint32_t reserved;
+        std::uint64_t signature;
+    };
+
+    struct SharedColumn {
+        char name[64]; // typeid name, truncated
+        std::uint32_t componentSize;
+        std::uint32_t count;
+        std::uint64_t entitiesOffset;
+        std::uint64_t componentsOffset;
+    };
+
+    struct SharedWorldHeader {
+        static constexpr std::uint32_t MAGIC = 0x53434554; // "TECS"
+        static constexpr std::uint32_t LAYOUT_VERSION = 1;
+
+        std::uint32_t magic;
+        std::uint32_t layoutVersion;
+        std::atomic<std::uint64_t> sequence;
+        std::uint64_t size;
+        std::uint64_t tick;
+        std::uint32_t entityCount;
+        std::uint32_t columnCount;
+        std::uint64_t entitiesOffset;
+        SharedColumn columns[MAX_COMPONENTS];
+    };
+    static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "The sequence has to be usable across processes");
+
+    // Publishes the entity table and the chosen component columns to POSIX shared memory from each extraction snapshot.
+    // Publishing runs with the other extraction systems, so the simulation thread never waits on it or on readers.
+    template<typename... Components>
+    class SharedWorldView : public ExtractionSystem {
+    public:
+        static_assert((std::is_trivially_copyable_v<Components> && ...), "Shared columns are copied as raw bytes");
+
+        SharedWorldView(Context& context, const std::string& name);
+        ~SharedWorldView() override;
+        SharedWorldView(const SharedWorldView&) = delete;
+        SharedWorldView& operator=(const SharedWorldView&) = delete;
+
+        void extract(const FrameSnapshot& snapshot) override;
+        [[nodiscard]] bool isShared() const { return m_Shared; } // False if the segment couldn't be created, frames then stay in process
+    private:
+        static Signature createSignature(Context& context);
+        template<typename T>
+        void publishColumn(const FrameSnapshot& snapshot, SharedColumn& column);
+
+        std::string m_Name;
+        std::size_t m_Size = 0;
+        std::byte* m_Segment = nullptr;
+        bool m_Shared = false;
+    };
+
+    // A consistent copy of a shared world, taken by SharedWorldReader
+    class SharedWorldFrame {
+    public:
+        [[nodiscard]] std::uint64_t getTick() const { return getHeader().tick; }
+        [[nodiscard]] std::span<const SharedEntity> getEntities() const;
+        // Components and the entities they belong to, index for index. Empty if the column isn't shared
+        template<typename T>
+        std::span<const T> getColumn(std::span<const EntityId>* entities = nullptr) const;
+    private:
+        friend class SharedWorldReader;
+        [[nodiscard]] const SharedWorldHeader& getHeader() const { return *reinterpret_cast<const SharedWorldHeader*>(m_Data.data()); }
+        std::vector<std::byte> m_Data; // 8 byte aligned by the allocator, which is all the layout asks for
+    };
+
+    // Attaches to a segment published by a SharedWorldView, usually from another process.
+    // The segment is mapped writable, though only read, so loading the sequence never touches read only pages. Without write access
+    // it falls back to a read only mapping, only on x86-64 and AArch64 where a lock free 64 bit atomic load is a plain load
+    class SharedWorldReader {
+    public:
+        explicit SharedWorldReader(const std::string& name);
+        ~SharedWorldReader();
+        SharedWorldReader(const SharedWorldReader&) = delete;
+        SharedWorldReader& operator=(const SharedWorldReader&) = delete;
+
+        [[nodiscard]] bool isOpen() const { return m_Segment != nullptr; }
+        // Retries while the writer is mid frame, returns false if it never got a consistent copy
+        bool read(SharedWorldFrame& frame, unsigned int attempts = 64) const;
+    private:
+        std::byte* m_Segment = nullptr;
+        std::size_t m_Size = 0;
+    };
+
+    // A Context whose component types are fixed at compile time. Storages live in a tuple and are called directly,
+    // type ids are positions in the pack and signatures are built with constexpr, so nothing goes through a virtual or a map.
+    // It covers the entity and component half of Context's API, so code using only that can switch with a typedef.
+    template<typename... Components>
+    class StaticContext {
+    public:
+        static_assert(sizeof...(Components) <= MAX_COMPONENTS, "Too many component types");
+
+        StaticContext() : m_EntityIndices() { m_EntityIndices.fill(tnull); }
+
+        // Entity methods
+        EntityId createEntity();
+        void destroyEntity(const EntityId entityId);
+        void destroyEntities(const std::vector<EntityId>& entityIds);
+        [[nodiscard]] bool isAlive(const EntityId entityId) const { return entityId < MAX_ENTITIES && m_EntityIndices[entityId] != tnull; }
+        [[nodiscard]] const std::vector<EntityId>& getEntities() const { return m_EntityList; }
+
+        // Component methods
+        template<typename T>
+        void registerComponentType(const StorageMode mode = StorageMode::Single, const AllocationPolicy policy = AllocationPolicy::Default);
+        template<typename T>
+        void addComponent(const EntityId entityId, T component);
+        template<typename T>
+        void removeComponent(const EntityId entityId);
+        template<typename T>
+        T& getComponent(const EntityId entityId) { return getComponentStorage<T>().get(entityId); }
+        template<typename T>
+        const T& readComponent(const EntityId entityId) const { return getComponentStorage<T>().get(entityId); }
+        template<typename T>
+        const T& getPreviousComponent(const EntityId entityId) const { return getComponentStorage<T>().getPrevious(entityId); }
+        template<typename T>
+        [[nodiscard]] bool hasComponent(const EntityId entityId) const { return m_EntitySignatures[entityId][getComponentTypeId<T>()]; }
+        template<typename T>
+        static constexpr ComponentTypeId getComponentTypeId();
+        template<typename... Types>
+        static constexpr Signature createSignature() { return Signature(((std::uint64_t{1} << getComponentTypeId<Types>()) | ... | 0)); }
+        template<typename T>
+        ComponentStorage<T>& getComponentStorage() { return std::get<ComponentStorage<T>>(m_ComponentStorages); }
+        template<typename T>
+        const ComponentStorage<T>& getComponentStorage() const { return std::get<ComponentStorage<T>>(m_ComponentStorages); }
+        void swapBuffers();
+
+        // Query methods
+        void collectEntities(const Signature& include, const Signature& exclude, std::vector<EntityId>& entityIds) const;
+        template<typename... Types, typename Function>
+        void view(Function&& function);
+
+    private:
+        template<std::size_t... Indices>
+        void removeAll(const EntityId entityId, const Signature& signature, std::index_sequence<Indices...>);
+
+        std::vector<EntityId> m_EntityList;
+        std::vector<EntityId> m_FreedEntityList;
+        std::array<unsigned int, MAX_ENTITIES> m_EntityIndices;
+        EntityBitmap m_AliveEntities;
+        std::array<Signature, MAX_ENTITIES> m_EntitySignatures;
+        EntityId nextEntityId = 0;
+
+        std::tuple<ComponentStorage<Components>...> m_ComponentStorages;
+    };
+}
+
+namespace ECS {
+    // Implement EntityBitmap
+    inline std::size_t EntityBitmap::count() const {
+        std::size_t count = 0;
+        for (const auto& word : m_Words)
+            count += std::popcount(word);
+        return count;
+    }
+
+    // Plain loops over a fixed number of words, which the compiler vectorises
+    inline EntityBitmap& EntityBitmap::operator&=(const EntityBitmap& other) {
+        for (std::size_t i = 0; i < WORD_COUNT; ++i)
+            m_Words[i] &= other.m_Words[i];
+        return *this;
+    }
+
+    inline EntityBitmap& EntityBitmap::andNot(const EntityBitmap& other) {
+        for (std::size_t i = 0; i < WORD_COUNT; ++i)
+            m_Words[i] &= ~other.m_Words[i];
+        return *this;
+    }
+
+    inline EntityBitmap& EntityBitmap::operator|=(const EntityBitmap& other) {
+        for (std::size_t i = 0; i < WORD_COUNT; ++i)
+            m_Words[i] |= other.m_Words[i];
+        return *this;
+    }
+
+    template<typename Function>
+    void EntityBitmap::forEach(Function&& function) const {
+        for (std::size_t i = 0; i < WORD_COUNT; ++i)
+            for (auto word = m_Words[i]; word != 0; word &= word - 1)
+                function(static_cast<EntityId>(i * 64 + std::countr_zero(word)));
+    }
+
+    // Implement ColumnAllocator
+    template<typename T>
+    bool ColumnAllocator<T>::usesHugePages() const noexcept {
+#ifdef __linux__
+        return m_Policy == AllocationPolicy::HugePages;
+#else
+        return false;
+#endif
+    }
+
+    template<typename T>
+    T* ColumnAllocator<T>::allocate(const std::size_t count) {
+        const auto bytes = count * sizeof(T);
+        if (!usesHugePages())
+            return std::allocator<T>().allocate(count);
+#ifdef __linux__
+        const auto length = (bytes + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+
+        // Explicit huge pages only work if the admin has reserved some, so this usually falls through
+        if (void* memory = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0); memory != MAP_FAILED)
+            return static_cast<T*>(memory);
+
+        // Otherwise map an extra huge page so the region can be trimmed to a huge page boundary, and ask for transparent huge pages
+        void* memory = mmap(nullptr, length + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED)
+            throw std::bad_alloc();
+        const auto address = reinterpret_cast<std::uintptr_t>(memory);
+        const auto aligned = (address + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+        if (aligned != address)
+            munmap(memory, aligned - address);
+        if (const auto tail = address + length + HUGE_PAGE_SIZE - (aligned + length); tail != 0)
+            munmap(reinterpret_cast<void*>(aligned + length), tail);
+        madvise(reinterpret_cast<void*>(aligned), length, MADV_HUGEPAGE);
+        return reinterpret_cast<T*>(aligned);
+#else
+        return nullptr;
+#endif
+    }
+
+    template<typename T>
+    void ColumnAllocator<T>::deallocate(T* pointer, const std::size_t count) noexcept {
+        const auto bytes = count * sizeof(T);
+        if (!usesHugePages())
+            return std::allocator<T>().deallocate(pointer, count);
+#ifdef __linux__
+        munmap(pointer, (bytes + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE);
+#endif
+    }
+
+    // Implement ComponentStorage
+
+    // IComponentStorage Overrides
+    template<typename T>
+    void ComponentStorage<T>::entitiesDestroyed(const EntityId* entityIds, const std::size_t count) {
+        for (std::size_t i = 0; i < count; ++i)
+            remove(entityIds[i]);
+    }
+
+    template<typename T>
+    void ComponentStorage<T>::swapBuffers() {
+        // Runs once the pipeline's systems have finished, so the flag is read without racing them
+        if (!isDoubleBuffered() || !std::atomic_ref(m_Unpublished).load(std::memory_order_relaxed))
+            return;
+        // Publishes by copying the write column over the read column. A pointer flip would leave writers starting from
+        // values two barriers old for every field they don't overwrite, so this is one contiguous copy, and only for
+        // storages something could have written since the last barrier
+        std::copy(m_Components.begin(), m_Components.end(), m_Previous.begin());
+        std::atomic_ref(m_Unpublished).store(false, std::memory_order_relaxed);
+    }
+
+    template<typename T>
+    void ComponentStorage<T>::copyInto(std::shared_ptr<IComponentStorage>& target) const {
+        if (!target)
+            target = std::make_shared<ComponentStorage<T>>(*this);
+        else
+            *std::static_pointer_cast<ComponentStorage<T>>(target) = *this; // Reuses the target's allocations
+    }
+
+    // Runs on a worker of the target node: writes the column's whole capacity so the kernel backs it with that node's memory
+    template<typename T>
+    void ComponentStorage<T>::firstTouch() {
+        const auto touch = [](Column& column) {
+            const auto size = column.size();
+            Column placed(column.get_allocator());
+            placed.reserve(std::max<std::size_t>(MAX_ENTITIES, size));
+            placed.resize(placed.capacity());
+            std::copy(column.begin(), column.end(), placed.begin());
+            placed.resize(size);
+            column.swap(placed);
+        };
+        touch(m_Components);
+        if (isDoubleBuffered())
+            touch(m_Previous);
+    }
+
+    template<typename T>
+    void ComponentStorage<T>::dump(std::ostream& os) const {
+        for (const auto& index : entityToIndexMap) {
+            if (index == tnull)
+                break;
+            os << "Entity: " << indexToEntityMap[index] << ", " << m_Components[index] << std::endl;
+        }
+    }
+
+    template<typename T>
+    void ComponentStorage<T>::deserialise(std::istringstream& iss, const EntityId entityId) {
+        T component;
+        iss >> component;
+        add(entityId, component);
+    }
+
+    // ComponentStorage Methods
+    template<typename T>
+    void ComponentStorage<T>::add(const EntityId entityId, T& component) {
+        const auto& index = m_Components.size();
+        m_Components.push_back(component);
+        if (isDoubleBuffered())
+            m_Previous.push_back(component);
+        entityToIndexMap[entityId] = index;
+        indexToEntityMap[index] = entityId;
+        m_Presence.set(entityId);
+        markChanged(entityId);
+    }
+
+    template<typename T>
+    void ComponentStorage<T>::remove(const EntityId entityId) {
+        const auto& index = entityToIndexMap[entityId];
+        const auto& lastIndex = m_Components.size() - 1;
+        m_Components[index] = m_Components[lastIndex];
+        m_Components.pop_back();
+        if (isDoubleBuffered()) {
+            m_Previous[index] = m_Previous[lastIndex];
+            m_Previous.pop_back();
+        }
+        entityToIndexMap[indexToEntityMap[lastIndex]] = index;
+        indexToEntityMap[index] = indexToEntityMap[lastIndex];
+        entityToIndexMap[entityId] = tnull;
+        indexToEntityMap[lastIndex] = tnull;
+        m_Presence.reset(entityId);
+        markChanged(entityId);
+    }
+
+    template<typename T>
+    T& ComponentStorage<T>::get(const EntityId entityId) {
+        // Systems in a pipeline can get the same storage concurrently, so only store when the flag moves
+        if (isDoubleBuffered())
+            if (std::atomic_ref unpublished(m_Unpublished); !unpublished.load(std::memory_order_relaxed))
+                unpublished.store(true, std::memory_order_relaxed);
+        return m_Components[entityToIndexMap[entityId]];
+    }
+
+    template<typename T>
+    T& ComponentStorage<T>::modify(const EntityId entityId) {
+        markChanged(entityId);
+        return get(entityId);
+    }
+
+    template<typename T>
+    const T& ComponentStorage<T>::get(const EntityId entityId) const {
+        return m_Components[entityToIndexMap[entityId]];
+    }
+
+    template<typename T>
+    const T& ComponentStorage<T>::getPrevious(const EntityId entityId) const {
+        return isDoubleBuffered() ? m_Previous[entityToIndexMap[entityId]] : m_Components[entityToIndexMap[entityId]];
+    }
+
+    template<typename T>
+    bool ComponentStorage<T>::has(const EntityId entityId) const {
+        return m_Presence.test(entityId);
+    }
+
+    // Implement System
+    inline bool System::isEnabled(const EntityId entityId) const {
+        return m_Context.isEnabledFor(entityId, m_Signature);
+    }
+
+    template<typename Function>
+    void System::forEachEnabled(Function&& function) const {
+        const bool filter = m_Context.hasDisabled();
+        for (const auto& entityId : m_Entities)
+            if (!filter || isEnabled(entityId))
+                function(entityId);
+    }
+
+    // Implement TypedSystem
+    template<typename Derived, typename... Accesses>
+    Signature TypedSystem<Derived, Accesses...>::createSignature(Context& context) {
+        return context.createSignature<typename Accesses::Type...>();
+    }
+
+    template<typename Derived, typename... Accesses>
+    TypedSystem<Derived, Accesses...>::TypedSystem(Context& context) : System(context, createSignature(context)) {
+        ((Accesses::WRITES ? m_WriteSignature.set(context.getComponentTypeId<typename Accesses::Type>()) : m_WriteSignature), ...);
+        m_DenseIndices.fill(tnull);
+    }
+
+    template<typename Derived, typename... Accesses>
+    void TypedSystem<Derived, Accesses...>::update() {
+        run(m_Dense, std::index_sequence_for<Accesses...>());
+    }
+
+    template<typename Derived, typename... Accesses>
+    void TypedSystem<Derived, Accesses...>::updateEntities(std::span<const EntityId> entityIds) {
+        run(entityIds, std::index_sequence_for<Accesses...>());
+    }
+
+    template<typename Derived, typename... Accesses>
+    template<std::size_t... Indices>
+    void TypedSystem<Derived, Accesses...>::run(std::span<const EntityId> entityIds, std::index_sequence<Indices...>) {
+        const std::tuple<ComponentStorage<typename Accesses::Type>*...> storages{m_Context.getComponentStorage<typename Accesses::Type>().get()...};
+        auto& derived = static_cast<Derived&>(*this);
+        if (!m_Context.hasDisabled()) {
+            for (const auto& entityId : entityIds)
+                derived.updateEntity(entityId, Accesses::get(*std::get<Indices>(storages), entityId)...);
+            return;
+        }
+        for (const auto& entityId : entityIds)
+            if (m_Context.isEnabledFor(entityId, m_Signature))
+                derived.updateEntity(entityId, Accesses::get(*std::get<Indices>(storages), entityId)...);
+    }
+
+    template<typename Derived, typename... Accesses>
+    bool TypedSystem<Derived, Accesses...>::insertEntity(const EntityId entityId) {
+        if (!System::insertEntity(entityId))
+            return false;
+        m_DenseIndices[entityId] = m_Dense.size();
+        m_Dense.push_back(entityId);
+        return true;
+    }
+
+    template<typename Derived, typename... Accesses>
+    bool TypedSystem<Derived, Accesses...>::eraseEntity(const EntityId entityId) {
+        if (!System::eraseEntity(entityId))
+            return false;
+        const auto index = m_DenseIndices[entityId];
+        m_Dense[index] = m_Dense.back();
+        m_DenseIndices[m_Dense[index]] = index;
+        m_Dense.pop_back();
+        m_DenseIndices[entityId] = tnull;
+        return true;
+    }
+
+    // Implement AmortisedSystem
+    inline void AmortisedSystem::update() {
+        constexpr std::size_t clockCheckInterval = 16; // Reading the clock per entity would cost more than most entity updates
+
+        const auto start = std::chrono::steady_clock::now();
+        std::size_t processed = 0;
+        while (m_Cursor < m_Order.size() && processed < m_EntityBudget) {
+            const auto entityId = m_Order[m_Cursor++];
+            if (!isEnabled(entityId))
+                continue;
+            updateEntity(entityId);
+            ++processed;
+            if (m_TimeBudget != std::chrono::microseconds::zero() && processed % clockCheckInterval == 0 &&
+                std::chrono::steady_clock::now() - start >= m_TimeBudget)
+                break;
+        }
+
+        ++m_Stats.updatesInCurrentSweep;
+        if (m_Cursor >= m_Order.size()) {
+            m_Cursor = 0;
+            ++m_Stats.completedSweeps;
+            m_Stats.updatesForLastSweep = m_Stats.updatesInCurrentSweep;
+            m_Stats.updatesInCurrentSweep = 0;
+        }
+        m_Stats.processedLastUpdate = processed;
+        m_Stats.pending = m_Order.size() - m_Cursor;
+    }
+
+    inline bool AmortisedSystem::insertEntity(const EntityId entityId) {
+        if (!System::insertEntity(entityId))
+            return false;
+        // New entities join the pending part of the sweep
+        m_OrderIndices[entityId] = m_Order.size();
+        m_Order.push_back(entityId);
+        return true;
+    }
+
+    inline bool AmortisedSystem::eraseEntity(const EntityId entityId) {
+        if (!System::eraseEntity(entityId))
+            return false;
+        std::size_t index = m_OrderIndices[entityId];
+        if (index < m_Cursor) {
+            // Keep the visited/pending split intact: move it to the end of the visited part, then swap it with the last entity
+            swapOrder(index, m_Cursor - 1);
+            index = --m_Cursor;
+        }
+        swapOrder(index, m_Order.size() - 1);
+        m_Order.pop_back();
+        m_OrderIndices[entityId] = tnull;
+        return true;
+    }
+
+    inline void AmortisedSystem::swapOrder(const std::size_t a, const std::size_t b) {
+        std::swap(m_Order[a], m_Order[b]);
+        m_OrderIndices[m_Order[a]] = a;
+        m_OrderIndices[m_Order[b]] = b;
+    }
+
+    // Implement FreedEntityStack
+    inline void FreedEntityStack::push(const EntityId entityId) {
+        auto head = m_Head.load(std::memory_order_relaxed);
+        std::uint64_t newHead;
+        do {
+            m_Links[entityId].store(static_cast<EntityId>(head), std::memory_order_relaxed);
+            newHead = ((head >> 32) + 1) << 32 | entityId;
+        } while (!m_Head.compare_exchange_weak(head, newHead, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    inline EntityId FreedEntityStack::pop() {
+        auto head = m_Head.load(std::memory_order_acquire);
+        while (true) {
+            const auto top = static_cast<EntityId>(head);
+            if (top == tnull)
+                return tnull;
+            const auto next = m_Links[top].load(std::memory_order_relaxed);
+            if (m_Head.compare_exchange_weak(head, ((head >> 32) + 1) << 32 | next, std::memory_order_acquire, std::memory_order_acquire))
+                return top;
+        }
+    }
+
+    inline std::vector<EntityId> FreedEntityStack::toVector() const {
+        std::vector<EntityId> entityIds;
+        for (auto entityId = static_cast<EntityId>(m_Head.load()); entityId != tnull; entityId = m_Links[entityId].load())
+            entityIds.push_back(entityId);
+        std::reverse(entityIds.begin(), entityIds.end());
+        return entityIds;
+    }
+
+    // Implement QueryPlan
+    inline void QueryPlan::explain(std::ostream& os) const {
+        const auto printStep = [&os](const Step& step) { os << step.typeName << " (" << step.size << " entities)"; };
+        if (strategy == Strategy::Drive) {
+            os << "Drive from ";
+            printStep(driving);
+            os << std::endl;
+        }
+        else
+            os << "Intersect presence bitmaps" << std::endl;
+        for (const auto& step : includeChecks) {
+            os << "  has ";
+            printStep(step);
+            os << std::endl;
+        }
+        for (const auto& step : excludeChecks) {
+            os << "  not ";
+            printStep(step);
+            os << std::endl;
+        }
+        os << "Estimated matches: " << estimatedMatches << ", estimated cost: " << estimatedCost << std::endl;
+    }
+
+    // Implement TimingWheel
+    inline TimerId TimingWheel::schedule(const std::uint64_t expiry, TimerCallback callback) {
+        unsigned int index;
+        if (!m_FreeTimers.empty()) {
+            index = m_FreeTimers.back();
+            m_FreeTimers.pop_back();
+        }
+        else {
+            index = m_Timers.size();
+            m_Timers.emplace_back();
+        }
+        auto& timer = m_Timers[index];
+        timer.expiry = std::max(expiry, m_Now + 1);
+        timer.callback = std::move(callback);
+        insert(index);
+        // The generation tells a stale id apart from a timer that reused its slot
+        return static_cast<TimerId>(timer.generation) << 32 | index;
+    }
+
+    inline bool TimingWheel::cancel(const TimerId timerId) {
+        const auto index = static_cast<unsigned int>(timerId);
+        if (index >= m_Timers.size() || m_Timers[index].generation != static_cast<unsigned int>(timerId >> 32) || m_Timers[index].list == NIL)
+            return false;
+        unlink(index);
+        m_Timers[index].callback = nullptr;
+        ++m_Timers[index].generation;
+        m_FreeTimers.push_back(index);
+        return true;
+    }
+
+    inline void TimingWheel::advanceTo(const std::uint64_t tick) {
+        while (m_Now < tick)
+            advance();
+    }
+
+    inline void TimingWheel::insert(const unsigned int index) {
+        const auto expiry = m_Timers[index].expiry;
+        const auto delta = expiry - m_Now;
+        for (unsigned int level = 0; level < LEVEL_COUNT; ++level) {
+            if (delta < std::uint64_t{1} << (LEVEL_BITS * (level + 1))) {
+                link(index, level * SLOT_COUNT + ((expiry >> (LEVEL_BITS * level)) & (SLOT_COUNT - 1)));
+                return;
+            }
+        }
+        link(index, OVERFLOW_LIST);
+    }
+
+    inline void TimingWheel::link(const unsigned int index, const unsigned int list) {
+        auto& timer = m_Timers[index];
+        timer.list = list;
+        timer.prev = NIL;
+        timer.next = m_Heads[list];
+        if (timer.next != NIL)
+            m_Timers[timer.next].prev = index;
+        m_Heads[list] = index;
+    }
+
+    inline void TimingWheel::unlink(const unsigned int index) {
+        auto& timer = m_Timers[index];
+        if (timer.prev != NIL)
+            m_Timers[timer.prev].next = timer.next;
+        else
+            m_Heads[timer.list] = timer.next;
+        if (timer.next != NIL)
+            m_Timers[timer.next].prev = timer.prev;
+        timer.list = timer.prev = timer.next = NIL;
+    }
+
+    inline void TimingWheel::advance() {
+        ++m_Now;
+
+        // Whenever a level wraps, the coarser level's current slot is due within its span and moves down
+        unsigned int level = 1;
+        for (; level < LEVEL_COUNT; ++level) {
+            if ((m_Now & ((std::uint64_t{1} << (LEVEL_BITS * level)) - 1)) != 0)
+                break;
+            const auto list = level * SLOT_COUNT + ((m_Now >> (LEVEL_BITS * level)) & (SLOT_COUNT - 1));
+            for (auto index = m_Heads[list]; index != NIL; index = m_Heads[list]) {
+                unlink(index);
+                insert(index);
+            }
+        }
+        if (level == LEVEL_COUNT && (m_Now & ((std::uint64_t{1} << (LEVEL_BITS * LEVEL_COUNT)) - 1)) == 0) {
+            for (auto index = m_Heads[OVERFLOW_LIST]; index != NIL;) {
+                const auto next = m_Timers[index].next;
+                if (m_Timers[index].expiry - m_Now < std::uint64_t{1} << (LEVEL_BITS * LEVEL_COUNT)) {
+                    unlink(index);
+                    insert(index);
+                }
+                index = next;
+            }
+        }
+
+        // Callbacks can schedule or cancel timers, but new ones always land on a later tick, so this list only shrinks
+        const auto list = static_cast<unsigned int>(m_Now & (SLOT_COUNT - 1));
+        for (auto index = m_Heads[list]; index != NIL; index = m_Heads[list]) {
+            unlink(index);
+            auto callback = std::move(m_Timers[index].callback);
+            m_Timers[index].callback = nullptr;
+            ++m_Timers[index].generation;
+            m_FreeTimers.push_back(index);
+            callback();
+        }
+    }
+
+    // Implement Query
+    inline void Query::refresh(const EntityId entityId, const Signature& signature) {
+        if (!matches(signature)) {
+            erase(entityId);
+            return;
+        }
+        if (contains(entityId))
+            return;
+        m_Indices[entityId] = m_Entities.size();
+        m_Entities.push_back(entityId);
+    }
+
+    inline void Query::erase(const EntityId entityId) {
+        if (!contains(entityId))
+            return;
+        const auto index = m_Indices[entityId];
+        m_Entities[index] = m_Entities.back();
+        m_Indices[m_Entities[index]] = index;
+        m_Entities.pop_back();
+        m_Indices[entityId] = tnull;
+    }
+
+    template<typename Function>
+    void Query::forEachEnabled(const Context& context, Function&& function) const {
+        const bool filter = context.hasDisabled();
+        for (const auto& entityId : m_Entities)
+            if (!filter || context.isEnabledFor(entityId, m_Include))
+                function(entityId);
+    }
+
+    // Implement Task
+    inline Task& Task::operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (m_Handle)
+                m_Handle.destroy();
+            m_Handle = std::exchange(other.m_Handle, {});
+        }
+        return *this;
+    }
+
+    // Implement FrameSnapshot
+    template<typename T>
+    ComponentTypeId FrameSnapshot::getComponentTypeId() const {
+        const auto typeIndex = TypeIndex<ComponentTypeFamily>::get<T>();
+        if (typeIndex >= m_ComponentTypeIds.size() || m_ComponentTypeIds[typeIndex] == MAX_COMPONENTS)
+            throw std::logic_error("Component type was not registered");
+        return m_ComponentTypeIds[typeIndex];
+    }
+
+    template<typename T>
+    const T& FrameSnapshot::getComponent(const EntityId entityId) const {
+        const auto& storage = m_ComponentStorages[getComponentTypeId<T>()];
+        assert(storage && "Component type was not declared by any extraction system");
+        return std::static_pointer_cast<const ComponentStorage<T>>(storage)->get(entityId);
+    }
+
+    template<typename T>
+    bool FrameSnapshot::hasComponent(const EntityId entityId) const {
+        return m_EntitySignatures[entityId][getComponentTypeId<T>()];
+    }
+
+    template<typename T>
+    const ComponentStorage<T>& FrameSnapshot::getStorage() const {
+        const auto& storage = m_ComponentStorages[getComponentTypeId<T>()];
+        assert(storage && "Component type was not declared by any extraction system");
+        return *std::static_pointer_cast<const ComponentStorage<T>>(storage);
+    }
+
+    // Implement NumaTopology
+    inline NumaTopology NumaTopology::detect() {
+        NumaTopology topology;
+#ifdef __linux__
+        cpu_set_t allowed;
+        CPU_ZERO(&allowed);
+        const bool hasAffinity = sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+
+        std::map<unsigned int, std::vector<unsigned int>> nodes;
+        std::error_code error;
+        for (const auto& entry : std::filesystem::directory_iterator("/sys/devices/system/node", error)) {
+            const auto name = entry.path().filename().string();
+            if (name.rfind("node", 0) != 0 || name.size() == 4 || name.find_first_not_of("0123456789", 4) != std::string::npos)
+                continue;
+
+            // cpulist looks like "0-3,8-11"
+            std::ifstream cpuList(entry.path() / "cpulist");
+            std::string range;
+            std::vector<unsigned int> cpus;
+            while (std::getline(cpuList, range, ',')) {
+                unsigned int first = 0, last = 0;
+                char dash = 0;
+                std::istringstream iss(range);
+                if (!(iss >> first))
+                    continue;
+                last = (iss >> dash >> last) ? last : first;
+                // cpu_set_t can't name CPUs past CPU_SETSIZE, so they can't be pinned to and are left out
+                last = std::min<unsigned int>(last, CPU_SETSIZE - 1);
+                for (auto cpu = first; cpu <= last; ++cpu)
+                    if (!hasAffinity || CPU_ISSET(cpu, &allowed)) // Skip CPUs this process isn't allowed to run on
+                        cpus.push_back(cpu);
+            }
+            if (!cpus.empty()) // Memory only nodes have no CPUs to run workers on
+                nodes[std::stoul(name.substr(4))] = std::move(cpus);
+        }
+        for (auto& [node, cpus] : nodes)
+            topology.nodeCpus.push_back(std::move(cpus));
+#endif
+        if (topology.nodeCpus.empty()) {
+            topology.nodeCpus.emplace_back();
+            for (unsigned int cpu = 0; cpu < std::max(1u, std::thread::hardware_concurrency()); ++cpu)
+                topology.nodeCpus.back().push_back(cpu);
+        }
+        return topology;
+    }
+
+    // Implement WaitGroup
+    inline void WaitGroup::add(const unsigned int count) {
+        std::lock_guard lock(m_Mutex);
+        m_Pending += count;
+    }
+
+    template<typename F>
+    void WaitGroup::run(F& job) {
+        std::exception_ptr exception;
+        try {
+            job();
+        } catch (...) {
+            exception = std::current_exception();
+        }
+        // Notified under the lock, so the waiter can't return and destroy the group while this is still using it
+        std::lock_guard lock(m_Mutex);
+        if (exception && !m_Exception)
+            m_Exception = exception;
+        if (--m_Pending == 0)
+            m_Condition.notify_all();
+    }
+
+    inline void WaitGroup::wait() {
+        std::unique_lock lock(m_Mutex);
+        m_Condition.wait(lock, [this] { return m_Pending == 0; });
+        if (m_Exception)
+            std::rethrow_exception(std::exchange(m_Exception, nullptr));
+    }
+
+    // Implement WorkerPool
+    inline WorkerPool::WorkerPool(const NumaTopology& topology) {
+        for (const auto& cpus : topology.nodeCpus) {
+            auto& queue = *m_Queues.emplace_back(std::make_unique<NodeQueue>());
+            for (std::size_t i = 0; i < cpus.size(); ++i) {
+                auto& worker = m_Workers.emplace_back(&WorkerPool::workerLoop, this, std::ref(queue));
+#ifdef __linux__
+                // Pinned to the node rather than a single CPU, so the scheduler can still balance within it
+                cpu_set_t nodeSet;
+                CPU_ZERO(&nodeSet);
+                for (const auto& cpu : cpus)
+                    if (cpu < CPU_SETSIZE)
+                        CPU_SET(cpu, &nodeSet);
+                pthread_setaffinity_np(worker.native_handle(), sizeof(nodeSet), &nodeSet);
+#else
+                (void)worker;
+#endif
+            }
+        }
+    }
+
+    inline WorkerPool::~WorkerPool() {
+        for (const auto& queue : m_Queues) {
+            std::lock_guard lock(queue->mutex);
+            queue->stopping = true;
+            queue->condition.notify_all();
+        }
+        for (auto& worker : m_Workers)
+            worker.join();
+    }
+
+    template<typename F>
+    std::future<std::invoke_result_t<F>> WorkerPool::submit(F&& job, unsigned int node) {
+        if (node == ANY_NUMA_NODE || node >= m_Queues.size())
+            node = m_NextNode.fetch_add(1, std::memory_order_relaxed) % m_Queues.size();
+
+        // Delegates need a copyable target, so the packaged_task is shared
+        auto task = std::make_shared<std::packaged_task<std::invoke_result_t<F>()>>(std::forward<F>(job));
+        auto future = task->get_future();
+        auto& queue = *m_Queues[node];
+        {
+            std::lock_guard lock(queue.mutex);
+            queue.jobs.emplace_back([task] { (*task)(); });
+        }
+        queue.condition.notify_one();
+        return future;
+    }
+
+    template<typename F>
+    void WorkerPool::post(WaitGroup& group, F&& job, unsigned int node) {
+        if (node == ANY_NUMA_NODE || node >= m_Queues.size())
+            node = m_NextNode.fetch_add(1, std::memory_order_relaxed) % m_Queues.size();
+
+        group.add();
+        auto& queue = *m_Queues[node];
+        {
+            std::lock_guard lock(queue.mutex);
+            queue.jobs.emplace_back([&group, job = std::forward<F>(job)]() mutable { group.run(job); });
+        }
+        queue.condition.notify_one();
+    }
+
+    inline void WorkerPool::workerLoop(NodeQueue& queue) {
+        while (true) {
+            Delegate<void()> job;
+            {
+                std::unique_lock lock(queue.mutex);
+                queue.condition.wait(lock, [&queue] { return queue.stopping || queue.next < queue.jobs.size(); });
+                if (queue.next == queue.jobs.size())
+                    return; // Stopping, and everything queued has run
+                job = std::move(queue.jobs[queue.next++]);
+                if (queue.next == queue.jobs.size()) {
+                    queue.jobs.clear();
+                    queue.next = 0;
+                }
+            }
+            job();
+        }
+    }
+
+    // Returns whether any system ran, so the caller knows if there is anything to publish at the barrier
+    template<typename Predicate>
+    bool SystemPipeline::run(WorkerPool& pool, Predicate predicate) const {
+        WaitGroup group;
+        bool ran = false;
+
+        for (const auto& system : m_Systems) {
+            if (predicate(*system)) {
+                pool.post(group, [system = system.get()] { system->update(); }, system->getNumaNode());
+                ran = true;
+            }
+        }
+
+        group.wait();
+        return ran;
+    }
+
+    inline bool SystemPipeline::update(WorkerPool& pool, const std::uint64_t tick) const {
+        return run(pool, [tick](const System& system) { return system.isDueOnTick(tick); });
+    }
+
+    inline bool SystemPipeline::updateFrame(WorkerPool& pool) const {
+        return run(pool, [](const System& system) { return system.isFrameSystem(); });
+    }
+
+    // Implement Context
+    inline Context::~Context() {
+        waitForExtraction();
+        m_WorkerPool.reset(); // Joins the workers once their queues are empty
+    }
+
+    inline EntityId Context::createEntity() {
+        EntityId entityId = m_FreedEntityList.pop();
+        if (entityId == tnull)
+            entityId = claimFreshIds(1).first;
+        if (entityId == MAX_ENTITIES)
+            throw std::length_error("Out of entity ids");
+        addEntity(entityId);
+        return entityId;
+    }
+
+    // Safe to call from any thread: the id is valid straight away, the entity joins the entity list when the command buffer is flushed
+    inline EntityId Context::createEntityDeferred() {
+        const auto entityId = reserveEntityId();
+        m_CommandBuffer.push([entityId](Context& context) { context.addEntity(entityId); });
+        return entityId;
+    }
+
+    inline EntityId Context::reserveEntityId() {
+        if (const auto entityId = m_FreedEntityList.pop(); entityId != tnull)
+            return entityId;
+
+        // Each thread takes a batch of fresh ids at a time, so threads don't all contend on nextEntityId.
+        // The slot a thread owns is remembered per context, and checked again since the slot is released at the end of every step
+        struct CachedSlot {
+            std::uint64_t contextSerial = 0;
+            std::size_t index = 0;
+        };
+        thread_local CachedSlot cached;
+        const auto self = std::this_thread::get_id();
+        IdReservation* reservation = nullptr;
+        if (cached.contextSerial == m_Serial && m_IdReservations[cached.index].owner.load(std::memory_order_acquire) == self) {
+            reservation = &m_IdReservations[cached.index];
+        } else {
+            for (std::size_t index = 0; index < m_IdReservations.size() && !reservation; ++index) {
+                std::thread::id unowned;
+                if (m_IdReservations[index].owner.compare_exchange_strong(unowned, self, std::memory_order_acquire)) {
+                    reservation = &m_IdReservations[index];
+                    cached = {m_Serial, index};
+                }
+            }
+        }
+
+        if (reservation) {
+            // Only ever held briefly by returnReservedIds, which may have released the slot in the meantime
+            while (reservation->busy.exchange(true, std::memory_order_acquire))
+                std::this_thread::yield();
+            if (reservation->owner.load(std::memory_order_relaxed) != self) {
+                reservation->busy.store(false, std::memory_order_release);
+                reservation = nullptr;
+            }
+        }
+
+        EntityId entityId = MAX_ENTITIES;
+        if (!reservation) {
+            entityId = claimFreshIds(1).first; // Every slot is owned, or ours was just released, so don't hold any ids back
+        } else {
+            if (reservation->next == reservation->end)
+                std::tie(reservation->next, reservation->end) = claimFreshIds(ENTITY_ID_BATCH);
+            if (reservation->next != reservation->end)
+                entityId = reservation->next++;
+            reservation->busy.store(false, std::memory_order_release);
+        }
+        if (entityId == MAX_ENTITIES)
+            throw std::length_error("Out of entity ids");
+        return entityId;
+    }
+
+    // Takes up to count ids that were never handed out, fewer close to MAX_ENTITIES, so nextEntityId never passes it.
+    // Returns {MAX_ENTITIES, MAX_ENTITIES} once every id has been handed out
+    inline std::pair<EntityId, EntityId> Context::claimFreshIds(const EntityId count) {
+        auto first = nextEntityId.load(std::memory_order_relaxed);
+        EntityId end;
+        do {
+            if (first >= MAX_ENTITIES)
+                return {MAX_ENTITIES, MAX_ENTITIES};
+            end = std::min(first + count, MAX_ENTITIES);
+        } while (!nextEntityId.compare_exchange_weak(first, end, std::memory_order_relaxed));
+        return {first, end};
+    }
+
+    // Runs at the end of the step. Unused ids go to the freed list so they aren't lost. Systems are done by now, but jobs
+    // started with runJob may still be reserving, so a slot whose owner is in the middle of it is left for a later step
+    inline void Context::returnReservedIds() {
+        for (auto& reservation : m_IdReservations) {
+            if (reservation.owner.load(std::memory_order_relaxed) == std::thread::id())
+                continue;
+            if (reservation.busy.exchange(true, std::memory_order_acquire))
+                continue;
+            for (auto entityId = reservation.next; entityId < reservation.end; ++entityId)
+                m_FreedEntityList.push(entityId);
+            reservation.next = reservation.end = 0;
+            reservation.owner.store(std::thread::id(), std::memory_order_relaxed);
+            reservation.busy.store(false, std::memory_order_release);
+        }
+    }
+
+    inline std::uint64_t Context::nextContextSerial() {
+        static std::atomic<std::uint64_t> serial = 1;
+        return serial.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    inline void Context::addEntity(const EntityId entityId) {
+        m_EntityList.push_back(entityId);
+        m_EntityIndices[entityId] = m_EntityList.size() - 1;
+        m_AliveEntities.set(entityId);
+
+        for (const auto& query : m_Queries)
+            query->refresh(entityId, m_EntitySignatures[entityId]);
+    }
+
+    inline void Context::destroyEntity(const EntityId entityId) {
+        if (m_EntityIndices[entityId] == tnull)
+            return;
+
+        // Only the storages and systems the entity's signature says it is in need to hear about it
+        const auto signature = m_EntitySignatures[entityId];
+        releaseEntity(entityId);
+
+        forEachComponentType(signature, [this, entityId](const ComponentTypeId typeId) {
+            m_ComponentStorages[typeId]->entitiesDestroyed(&entityId, 1);
+        });
+
+        for (const auto& system : m_Systems)
+            if (const auto& systemSignature = system->getSignature(); (signature & systemSignature) == systemSignature)
+                system->eraseEntity(entityId);
+
+        for (const auto& query : m_Queries)
+            query->erase(entityId);
+    }
+
+    inline void Context::destroyEntities(const std::vector<EntityId>& entityIds) {
+        // Group by component type so each storage is called once for the whole batch
+        std::vector<std::pair<EntityId, Signature>> destroyed;
+        destroyed.reserve(entityIds.size());
+        for (const auto& entityId : entityIds) {
+            if (m_EntityIndices[entityId] == tnull)
+                continue; // Already destroyed, or listed twice
+            const auto signature = m_EntitySignatures[entityId];
+            destroyed.emplace_back(entityId, signature);
+            releaseEntity(entityId);
+            forEachComponentType(signature, [this, entityId](const ComponentTypeId typeId) {
+                m_DestroyBatches[typeId].push_back(entityId);
+            });
+        }
+
+        for (ComponentTypeId typeId = 0; typeId < nextComponentTypeId; ++typeId) {
+            auto& batch = m_DestroyBatches[typeId];
+            if (batch.empty())
+                continue;
+            m_ComponentStorages[typeId]->entitiesDestroyed(batch.data(), batch.size());
+            batch.clear();
+        }
+
+        for (const auto& system : m_Systems) {
+            const auto& systemSignature = system->getSignature();
+            for (const auto& [entityId, signature] : destroyed)
+                if ((signature & systemSignature) == systemSignature)
+                    system->eraseEntity(entityId);
+        }
+
+        for (const auto& query : m_Queries)
+            for (const auto& [entityId, signature] : destroyed)
+                query->erase(entityId);
+    }
+
+    // Removes the entity from the entity list and frees its id, returning false if it wasn't alive
+    inline bool Context::releaseEntity(const EntityId entityId) {
+        if (m_EntityIndices[entityId] == tnull)
+            return false;
+
+        m_FreedEntityList.push(entityId);
+        m_EntitySignatures[entityId].reset();
+
+        m_EntityList[m_EntityIndices[entityId]] = m_EntityList.back(); // Move the last entity to the destroyed entity's place
+        m_EntityIndices[m_EntityList.back()] = m_EntityIndices[entityId]; // Update the index of the moved entity
+
+        m_EntityList.pop_back(); // Remove the last entity
+        m_EntityIndices[entityId] = tnull; // Invalidate the destroyed entity's index
+        m_AliveEntities.reset(entityId);
+
+        // A reused id starts out enabled
+        setEntityEnabled(entityId, true);
+        forEachComponentType(m_DisabledComponents[entityId], [this, entityId](const ComponentTypeId typeId) {
+            setComponentEnabled(entityId, typeId, true);
+        });
+        return true;
+    }
+
+    inline void Context::setEntityEnabled(const EntityId entityId, const bool enabled) {
+        if (isEntityEnabled(entityId) == enabled)
+            return;
+        if (enabled) {
+            m_DisabledEntities.reset(entityId);
+            --m_DisabledCount;
+        } else {
+            m_DisabledEntities.set(entityId);
+            ++m_DisabledCount;
+        }
+    }
+
+    inline void Context::setComponentEnabled(const EntityId entityId, const ComponentTypeId typeId, const bool enabled) {
+        if (m_DisabledComponents[entityId][typeId] != enabled)
+            return;
+        m_DisabledComponents[entityId][typeId] = !enabled;
+        if (enabled) {
+            m_DisabledComponentBitmaps[typeId].reset(entityId);
+            --m_DisabledCount;
+        } else {
+            m_DisabledComponentBitmaps[typeId].set(entityId);
+            ++m_DisabledCount;
+        }
+    }
+
+    inline bool Context::isEnabledFor(const EntityId entityId, const Signature& signature) const {
+        return !m_DisabledEntities.test(entityId) && (m_DisabledComponents[entityId] & signature).none();
+    }
+
+    template<typename T>
+    void Context::registerComponentType(const StorageMode mode, const AllocationPolicy policy) {
+        if (nextComponentTypeId >= MAX_COMPONENTS)
+            throw std::length_error("Out of component type ids");
+        const auto typeIndex = TypeIndex<ComponentTypeFamily>::get<T>();
+        if (typeIndex >= m_ComponentTypeIds.size())
+            m_ComponentTypeIds.resize(typeIndex + 1, MAX_COMPONENTS);
+        m_ComponentTypeIds[typeIndex] = nextComponentTypeId;
+        for (auto& signature : m_SignatureCache)
+            signature.store(0, std::memory_order_relaxed); // Re-registering a type changes its id
+        m_ComponentTypes[typeid(T).name()] = nextComponentTypeId;
+        m_ComponentTypeNames[nextComponentTypeId] = typeid(T).name();
+        m_ComponentStorages[nextComponentTypeId] = std::make_shared<ComponentStorage<T>>(mode, policy);
+        m_ComponentStorages[nextComponentTypeId]->setChangeEpoch(m_ChangeEpoch);
+        if (mode == StorageMode::DoubleBuffered) {
+            m_DoubleBufferedStorages.push_back(m_ComponentStorages[nextComponentTypeId]);
+            m_DoubleBufferedTypes.set(nextComponentTypeId);
+        }
+        ++nextComponentTypeId;
+    }
+
+    template<typename T>
+    void Context::addComponent(const EntityId entityId, T component) {
+        getComponentStorage<T>()->add(entityId, component);
+        const auto& typeId = getComponentTypeId<T>();
+        m_EntitySignatures[entityId].set(typeId);
+
+        const auto& entitySignature = m_EntitySignatures[entityId];
+        for (const auto& system : m_Systems) {
+            if (const Signature& systemSignature = system->getSignature(); (entitySignature & systemSignature) == systemSignature)
+                system->insertEntity(entityId);
+        }
+
+        for (const auto& query : m_Queries)
+            query->refresh(entityId, entitySignature);
+    }
+
+    template<typename T>
+    void Context::removeComponent(const EntityId entityId) {
+        const auto& typeId = getComponentTypeId<T>();
+        setComponentEnabled(entityId, typeId, true); // So adding it back starts out enabled
+        m_EntitySignatures[entityId].reset(typeId);
+        getComponentStorage<T>()->remove(entityId);
+        const auto& entitySignature = m_EntitySignatures[entityId];
+        for (const auto& system : m_Systems) {
+            if (const Signature& systemSignature = system->getSignature(); (entitySignature & systemSignature) != systemSignature)
+                system->eraseEntity(entityId);
+        }
+
+        for (const auto& query : m_Queries)
+            query->refresh(entityId, entitySignature);
+    }
+
+    // Not recorded as a change, so systems can read through it concurrently. Writes that reactive events or replication
+    // should see go through modifyComponent
+    template<typename T>
+    T& Context::getComponent(const EntityId entityId) {
+        return getComponentStorage<T>()->get(entityId);
+    }
+
+    template<typename T>
+    T& Context::modifyComponent(const EntityId entityId) {
+        return getComponentStorage<T>()->modify(entityId);
+    }
+
+    template<typename T>
+    const T& Context::readComponent(const EntityId entityId) {
+        return std::as_const(*getComponentStorage<T>()).get(entityId);
+    }
+
+    template<typename T>
+    const T& Context::getPreviousComponent(const EntityId entityId) {
+        return getComponentStorage<T>()->getPrevious(entityId);
+    }
+
+    template<typename T>
+    bool Context::hasComponent(const EntityId entityId) {
+        const auto typeId = getComponentTypeId<T>();
+        return m_EntitySignatures[entityId][typeId];
+    }
+
+    template<typename T>
+    void Context::setComponentEnabled(const EntityId entityId, const bool enabled) {
+        setComponentEnabled(entityId, getComponentTypeId<T>(), enabled);
+    }
+
+    template<typename T>
+    ComponentTypeId Context::getComponentTypeId() const {
+        if (!isComponentRegistered<T>())
+            throw std::logic_error("Component type was not registered");
+        return m_ComponentTypeIds[TypeIndex<ComponentTypeFamily>::get<T>()];
+    }
+
+    template<typename T>
+    bool Context::isComponentRegistered() const {
+        const auto typeIndex = TypeIndex<ComponentTypeFamily>::get<T>();
+        return typeIndex < m_ComponentTypeIds.size() && m_ComponentTypeIds[typeIndex] != MAX_COMPONENTS;
+    }
+
+    // Built the first time a component list is used and looked up by its TypeIndex afterwards.
+    // A non-empty list never has an empty signature, so 0 means it hasn't been built yet. Two threads building
+    // the same list store the same bits, so relaxed is enough. Lists past the cache are built on every call
+    template<typename... Components>
+    Signature Context::createSignature() {
+        const auto setIndex = TypeIndex<SignatureFamily>::get<Components...>();
+        if (setIndex < SIGNATURE_CACHE_SIZE)
+            if (const auto bits = m_SignatureCache[setIndex].load(std::memory_order_relaxed); bits != 0)
+                return Signature(bits);
+
+        Signature signature;
+        (signature.set(getComponentTypeId<Components>()), ...);
+        if (setIndex < SIGNATURE_CACHE_SIZE)
+            m_SignatureCache[setIndex].store(signature.to_ullong(), std::memory_order_relaxed);
+        return signature;
+    }
+
+    template<typename T>
+    std::shared_ptr<ComponentStorage<T>> Context::getComponentStorage() {
+        const auto typeId = getComponentTypeId<T>();
+        return std::static_pointer_cast<ComponentStorage<T>>(m_ComponentStorages[typeId]);
+    }
+
+    template<typename T>
+    void Context::placeComponentStorage(const unsigned int node) {
+        const auto typeId = getComponentTypeId<T>();
+        const auto storage = getComponentStorage<T>();
+        storage->setNumaNode(node);
+        getWorkerPool().submit([storage] { storage->firstTouch(); }, node).get();
+
+        for (const auto& system : m_Systems)
+            if (system->getNumaNode() == ANY_NUMA_NODE && system->getSignature()[typeId])
+                system->setNumaNode(node);
+    }
+
+    inline std::shared_ptr<Query> Context::addQuery(const Signature& include, const Signature& exclude) {
+        auto query = std::make_shared<Query>(include, exclude);
+        // Queries match on the components entities have, like their later refreshes. collectEntities also applies the
+        // enabled bits, so it is only used to seed them while nothing is disabled
+        if (!hasDisabled()) {
+            std::vector<EntityId> entityIds;
+            collectEntities(include, exclude, entityIds);
+            for (const auto& entityId : entityIds)
+                query->refresh(entityId, m_EntitySignatures[entityId]);
+        } else {
+            for (const auto& entityId : m_EntityList)
+                query->refresh(entityId, m_EntitySignatures[entityId]);
+        }
+        m_Queries.push_back(query);
+        return query;
+    }
+
+    inline void Context::collectEntities(const Signature& include, const Signature& exclude, std::vector<EntityId>& entityIds) const {
+        entityIds.clear();
+
+        if (const auto plan = planQuery(include, exclude); plan.strategy == QueryPlan::Strategy::Drive) {
+            const auto& storage = m_ComponentStorages[plan.driving.typeId];
+            const auto* const drivingEntities = storage->entities();
+            for (std::size_t i = 0, size = storage->size(); i < size; ++i) {
+                const auto entityId = drivingEntities[i];
+                // A disabled component counts as absent
+                const auto matches =
+                    std::all_of(plan.includeChecks.begin(), plan.includeChecks.end(), [this, entityId](const QueryPlan::Step& step) {
+                        return m_ComponentStorages[step.typeId]->getPresence().test(entityId);
+                    }) &&
+                    std::none_of(plan.excludeChecks.begin(), plan.excludeChecks.end(), [this, entityId](const QueryPlan::Step& step) {
+                        return m_ComponentStorages[step.typeId]->getPresence().test(entityId) && !m_DisabledComponents[entityId][step.typeId];
+                    }) &&
+                    (!hasDisabled() || isEnabledFor(entityId, include));
+                if (matches)
+                    entityIds.push_back(entityId);
+            }
+            return;
+        }
+
+        EntityBitmap candidates = m_AliveEntities;
+        forEachComponentType(include, [this, &candidates](const ComponentTypeId typeId) {
+            candidates &= m_ComponentStorages[typeId]->getPresence();
+        });
+        forEachComponentType(exclude, [this, &candidates](const ComponentTypeId typeId) {
+            if (!hasDisabled()) {
+                candidates.andNot(m_ComponentStorages[typeId]->getPresence());
+                return;
+            }
+            EntityBitmap present = m_ComponentStorages[typeId]->getPresence();
+            present.andNot(m_DisabledComponentBitmaps[typeId]);
+            candidates.andNot(present);
+        });
+        if (hasDisabled()) {
+            candidates.andNot(m_DisabledEntities);
+            forEachComponentType(include, [this, &candidates](const ComponentTypeId typeId) {
+                candidates.andNot(m_DisabledComponentBitmaps[typeId]);
+            });
+        }
+
+        entityIds.reserve(candidates.count());
+        candidates.forEach([&entityIds](const EntityId entityId) { entityIds.push_back(entityId); });
+    }
+
+    inline QueryPlan Context::planQuery(const Signature& include, const Signature& exclude) const {
+        // Rough relative costs: one bitmap word operation against one random bitmap test per candidate entity
+        constexpr double wordCost = 1.0;
+        constexpr double testCost = 2.0;
+
+        QueryPlan plan;
+        const auto alive = std::max<double>(1.0, static_cast<double>(m_EntityList.size()));
+        const auto makeStep = [this](const ComponentTypeId typeId) {
+            return QueryPlan::Step{typeId, m_ComponentTypeNames[typeId], m_ComponentStorages[typeId]->size()};
+        };
+        forEachComponentType(include, [&](const ComponentTypeId typeId) { plan.includeChecks.push_back(makeStep(typeId)); });
+        forEachComponentType(exclude, [&](const ComponentTypeId typeId) { plan.excludeChecks.push_back(makeStep(typeId)); });
+
+        std::sort(plan.includeChecks.begin(), plan.includeChecks.end(), [](const auto& a, const auto& b) { return a.size < b.size; });
+        std::sort(plan.excludeChecks.begin(), plan.excludeChecks.end(), [](const auto& a, const auto& b) { return a.size > b.size; });
+
+        plan.estimatedMatches = alive;
+        for (const auto& step : plan.includeChecks)
+            plan.estimatedMatches *= static_cast<double>(step.size) / alive;
+        for (const auto& step : plan.excludeChecks)
+            plan.estimatedMatches *= 1.0 - static_cast<double>(step.size) / alive;
+
+        const auto bitmapCost = wordCost * EntityBitmap::WORD_COUNT * (1 + plan.includeChecks.size() + plan.excludeChecks.size()) + plan.estimatedMatches;
+        plan.estimatedCost = bitmapCost;
+        if (plan.includeChecks.empty())
+            return plan; // Nothing to drive from
+
+        // Driving from the smallest storage: each later check only runs for the candidates that survived the earlier ones
+        const auto driving = plan.includeChecks.front();
+        double survivors = static_cast<double>(driving.size);
+        double driveCost = survivors;
+        for (std::size_t i = 1; i < plan.includeChecks.size(); ++i) {
+            driveCost += testCost * survivors;
+            survivors *= static_cast<double>(plan.includeChecks[i].size) / alive;
+        }
+        for (const auto& step : plan.excludeChecks) {
+            driveCost += testCost * survivors;
+            survivors *= 1.0 - static_cast<double>(step.size) / alive;
+        }
+
+        if (driveCost < bitmapCost) {
+            plan.strategy = QueryPlan::Strategy::Drive;
+            plan.driving = driving;
+            plan.includeChecks.erase(plan.includeChecks.begin());
+            plan.estimatedCost = driveCost;
+        }
+        return plan;
+    }
+
+    template<typename... Components, typename Function>
+    void Context::view(Function&& function) {
+        const auto storages = std::make_tuple(getComponentStorage<Components>()...);
+        const auto& signature = createSignature<Components...>();
+        std::vector<EntityId> entityIds;
+        collectEntities(signature, Signature(), entityIds);
+        [&]<std::size_t... Indices>(std::index_sequence<Indices...>) {
+            for (const auto& entityId : entityIds)
+                function(entityId, getViewComponent<viewWrites<Function, Indices, Components...>(std::index_sequence<Indices...>())>(*std::get<Indices>(storages), entityId)...);
+        }(std::index_sequence_for<Components...>());
+    }
+
+    inline void Context::removeQuery(const std::shared_ptr<Query>& query) {
+        std::erase(m_Queries, query);
+    }
+
+    inline void Context::addSystem(const std::shared_ptr<System>& system, unsigned int pipelineIndex) {
+        m_Systems.emplace_back(system);
+
+        // Unless told otherwise, run the system on the node holding the first of its components that has been placed
+        for (ComponentTypeId typeId = 0; typeId < MAX_COMPONENTS && system->getNumaNode() == ANY_NUMA_NODE; ++typeId)
+            if (system->getSignature()[typeId] && m_ComponentStorages[typeId])
+                system->setNumaNode(m_ComponentStorages[typeId]->getNumaNode());
+
+        if (m_SystemPipelines.size() <= pipelineIndex)
+            m_SystemPipelines.resize(pipelineIndex + 1);
+
+        if (!m_SystemPipelines[pipelineIndex])
+            m_SystemPipelines[pipelineIndex] = std::make_shared<SystemPipeline>();
+
+        m_SystemPipelines[pipelineIndex]->addSystem(system);
+
+        const auto& systemSignature = system->getSignature();
+        for (const auto& entityId : m_EntityList) {
+            const auto& entitySignature = m_EntitySignatures[entityId];
+            if ((entitySignature & systemSignature) == systemSignature)
+                system->insertEntity(entityId);
+        }
+    }
+
+    inline TimerId Context::scheduleTimer(const std::uint64_t delay, TimerCallback callback) {
+        return m_TimingWheel.schedule(m_Tick + delay, std::move(callback));
+    }
+
+    // Adds the component when the timer fires, or overwrites it if the entity already has one
+    template<typename T>
+    TimerId Context::scheduleComponent(const std::uint64_t delay, const EntityId entityId, T component) {
+        return scheduleTimer(delay, [this, entityId, component = std::move(component)] {
+            if (m_EntityIndices[entityId] == tnull)
+                return;
+            if (hasComponent<T>(entityId))
+                modifyComponent<T>(entityId) = component;
+            else
+                addComponent(entityId, component);
+        });
+    }
+
+    inline void Context::spawn(Task task) {
+        const auto handle = task.m_Handle;
+        m_Tasks.push_back(std::move(task));
+        handle.resume(); // Runs until its first co_await
+    }
+
+    template<typename F>
+    JobAwaiter<std::invoke_result_t<F>> Context::runJob(F&& job) {
+        return JobAwaiter<std::invoke_result_t<F>>{*this, getWorkerPool().submit(std::forward<F>(job))};
+    }
+
+    inline WorkerPool& Context::getWorkerPool() {
+        if (!m_WorkerPool)
+            m_WorkerPool = std::make_unique<WorkerPool>();
+        return *m_WorkerPool;
+    }
+
+    inline void Context::resumeFrameWaiters() {
+        // Take the lists first, resumed tasks may immediately wait again
+        auto jobWaiters = std::exchange(m_JobWaiters, {});
+        for (auto& [isReady, handle] : jobWaiters) {
+            if (isReady())
+                handle.resume();
+            else
+                m_JobWaiters.emplace_back(std::move(isReady), handle);
+        }
+
+        for (const auto& handle : std::exchange(m_NextFrameWaiters, {}))
+            handle.resume();
+    }
+
+    inline void Context::resumePipelineWaiters(const std::size_t pipelineIndex) {
+        if (pipelineIndex >= m_PipelineWaiters.size())
+            return;
+        for (const auto& handle : std::exchange(m_PipelineWaiters[pipelineIndex], {}))
+            handle.resume();
+    }
+
+    inline void Context::reapTasks() {
+        std::exception_ptr exception;
+        std::erase_if(m_Tasks, [&exception](const Task& task) {
+            if (!task.done())
+                return false;
+            if (task.m_Handle.promise().exception && !exception)
+                exception = task.m_Handle.promise().exception;
+            return true;
+        });
+        if (exception)
+            std::rethrow_exception(exception);
+    }
+
+    inline void Context::addExtractionSystem(const std::shared_ptr<ExtractionSystem>& system) {
+        waitForExtraction();
+        m_ExtractionSystems.push_back(system);
+        m_ExtractionSignature |= system->getSignature();
+    }
+
+    inline void Context::extract() {
+        // The previous frame's extraction has to finish before its snapshot is overwritten
+        waitForExtraction();
+
+        forEachComponentType(m_ExtractionSignature, [this](const ComponentTypeId typeId) {
+            if (m_ComponentStorages[typeId])
+                m_ComponentStorages[typeId]->copyInto(m_Snapshot.m_ComponentStorages[typeId]);
+        });
+        m_Snapshot.m_ComponentTypeIds = m_ComponentTypeIds;
+        m_Snapshot.m_EntitySignatures = m_EntitySignatures;
+        m_Snapshot.m_AliveEntities = m_AliveEntities;
+        m_Snapshot.m_Tick = m_Tick;
+
+        for (const auto& system : m_ExtractionSystems) {
+            collectEntities(system->getSignature(), Signature(), system->getEntities());
+        }
+
+        auto& pool = getWorkerPool();
+        for (const auto& system : m_ExtractionSystems)
+            pool.post(m_ExtractionGroup, [this, system = system.get()] { system->extract(m_Snapshot); });
+    }
+
+    inline void Context::waitForExtraction() {
+        m_ExtractionGroup.wait();
+    }
+
+    // Callers hold m_EventMutex
+    inline EventChannel& Context::getEventChannel(const EventId eventId) {
+        if (const auto it = m_EventChannelIndices.find(eventId); it != m_EventChannelIndices.end())
+            return m_EventChannels[it->second];
+        m_EventChannelIndices[eventId] = m_EventChannels.size();
+        m_EventDispatchOrderDirty = true;
+        auto& channel = m_EventChannels.emplace_back();
+        channel.eventId = eventId;
+        return channel;
+    }
+
+    inline void Context::addEvent(const EventId eventId, const EventCondition& eventCondition) {
+        std::lock_guard lock(m_EventMutex);
+        getEventChannel(eventId).condition = eventCondition;
+    }
+
+    inline void Context::addEvent(const EventId eventId, const EventCondition& eventCondition, const Signature& dependencies, const std::vector<EntityId>& watchedEntities) {
+        std::lock_guard lock(m_EventMutex);
+        auto& channel = getEventChannel(eventId);
+        channel.condition = eventCondition;
+        channel.dependencies = dependencies;
+        channel.watchedEntities = watchedEntities;
+        channel.evaluatedEpoch = 0;
+    }
+
+    inline void Context::addEventHandler(const EventId eventId, const EventHandler& eventHandler) {
+        std::lock_guard lock(m_EventMutex);
+        getEventChannel(eventId).handlers.push_back(eventHandler);
+    }
+
+    inline void Context::addEventHandler(const EventId eventId, const PayloadEventHandler& eventHandler) {
+        std::lock_guard lock(m_EventMutex);
+        getEventChannel(eventId).payloadHandlers.push_back(eventHandler);
+    }
+
+    inline void Context::addEventHandler(const EventId eventId, const ParallelEventHandler& eventHandler) {
+        std::lock_guard lock(m_EventMutex);
+        getEventChannel(eventId).parallelHandlers.push_back(eventHandler);
+    }
+
+    inline void Context::setEventThreadSafe(const EventId eventId, const bool threadSafe) {
+        std::lock_guard lock(m_EventMutex);
+        getEventChannel(eventId).threadSafe = threadSafe;
+        m_EventDispatchOrderDirty = true;
+    }
+
+    inline void Context::setEventPolicy(const EventId eventId, const CoalescePolicy policy, const unsigned int lane) {
+        std::lock_guard lock(m_EventMutex);
+        auto& channel = getEventChannel(eventId);
+        channel.policy = policy;
+        channel.lane = lane;
+        m_EventDispatchOrderDirty = true;
+    }
+
+    // Safe to call from systems: emissions are merged here, so only one payload per key is kept until updateEvents
+    inline void Context::emitEvent(const EventId eventId, const EventPayload& payload) {
+        std::lock_guard lock(m_EventMutex);
+        auto& channel = getEventChannel(eventId);
+        if (channel.policy == CoalescePolicy::None) {
+            channel.pending.push_back(payload);
+            return;
+        }
+
+        const auto [it, inserted] = channel.pendingIndices.try_emplace(payload.entity, channel.pending.size());
+        if (inserted) {
+            channel.pending.push_back(payload);
+            return;
+        }
+        auto& merged = channel.pending[it->second];
+        if (channel.policy == CoalescePolicy::KeepLatest)
+            merged.value = payload.value;
+        else if (channel.policy == CoalescePolicy::Accumulate)
+            merged.value += payload.value;
+        merged.count += payload.count;
+    }
+
+    inline bool Context::evaluateEventCondition(EventChannel& channel) {
+        if (!channel.condition)
+            return false;
+
+        bool stale = channel.dependencies.none() || channel.evaluatedEpoch == 0;
+        forEachComponentType(channel.dependencies, [&](const ComponentTypeId typeId) {
+            const auto& storage = m_ComponentStorages[typeId];
+            assert(storage && "Event depends on a component type that hasn't been registered.");
+            if (stale || !storage->changedSince(channel.evaluatedEpoch))
+                return;
+            if (channel.watchedEntities.empty()) {
+                stale = true;
+                return;
+            }
+            for (const auto& entityId : channel.watchedEntities)
+                stale = stale || storage->changedSince(entityId, channel.evaluatedEpoch);
+        });
+
+        if (stale) {
+            channel.lastResult = channel.condition();
+            channel.evaluatedEpoch = m_ChangeEpoch;
+        }
+        return channel.lastResult;
+    }
+
+    // Small workloads aren't worth a round trip through the pool, so they run on the caller
+    template<typename F>
+    void Context::forEachEventBatch(const std::size_t count, F&& function) {
+        if (count <= EVENT_BATCH_SIZE) {
+            for (std::size_t i = 0; i < count; ++i)
+                function(i);
+            return;
+        }
+
+        WaitGroup group;
+        for (std::size_t first = 0; first < count; first += EVENT_BATCH_SIZE) {
+            const auto last = std::min(count, first + EVENT_BATCH_SIZE);
+            getWorkerPool().post(group, [&function, first, last] {
+                for (auto i = first; i < last; ++i)
+                    function(i);
+            });
+        }
+        group.wait(); // Rethrows anything a condition or handler threw
+    }
+
+    inline std::uint32_t Context::advanceChangeEpoch() {
+        ++m_ChangeEpoch;
+        for (const auto& storage : m_ComponentStorages)
+            if (storage)
+                storage->setChangeEpoch(m_ChangeEpoch);
+        return m_ChangeEpoch;
+    }
+
+    inline void Context::updateEvents() {
+        // Anything written from here on, including by handlers, is seen by conditions on the next update
+        advanceChangeEpoch();
+
+        std::vector<std::pair<std::size_t, std::vector<EventPayload>>> emitted;
+        {
+            std::lock_guard lock(m_EventMutex);
+            if (m_EventDispatchOrderDirty) {
+                m_EventDispatchOrder.resize(m_EventChannels.size());
+                for (std::size_t i = 0; i < m_EventDispatchOrder.size(); ++i)
+                    m_EventDispatchOrder[i] = i;
+                std::stable_sort(m_EventDispatchOrder.begin(), m_EventDispatchOrder.end(), [this](const std::size_t a, const std::size_t b) {
+                    return m_EventChannels[a].lane < m_EventChannels[b].lane;
+                });
+                m_ThreadSafeEvents.clear();
+                for (const auto& index : m_EventDispatchOrder)
+                    if (m_EventChannels[index].threadSafe)
+                        m_ThreadSafeEvents.push_back(index);
+                m_EventDispatchOrderDirty = false;
+            }
+            // Take this update's emissions, anything emitted by a handler is dispatched next update
+            for (const auto& index : m_EventDispatchOrder) {
+                auto& channel = m_EventChannels[index];
+                if (channel.pending.empty())
+                    continue;
+                emitted.emplace_back(index, std::move(channel.pending));
+                channel.pending.clear();
+                channel.pendingIndices.clear();
+            }
+        }
+
+        // Thread safe conditions are evaluated up front, so they don't see what this update's handlers do
+        forEachEventBatch(m_ThreadSafeEvents.size(), [this](const std::size_t i) {
+            evaluateEventCondition(m_EventChannels[m_ThreadSafeEvents[i]]);
+        });
+
+        m_FiredParallelHandlers.clear();
+        // Handlers may register events or handlers, so channels are looked up again rather than held across calls,
+        // and each handler is called through a copy in case registering one reallocates the list it lives in
+        auto next = emitted.begin();
+        for (const auto& index : m_EventDispatchOrder) {
+            auto& channel = m_EventChannels[index];
+            if (channel.threadSafe ? channel.lastResult : evaluateEventCondition(channel)) {
+                for (std::size_t i = 0, count = channel.handlers.size(); i < count; ++i) {
+                    const auto handler = m_EventChannels[index].handlers[i];
+                    handler();
+                }
+                for (std::size_t i = 0; i < m_EventChannels[index].parallelHandlers.size(); ++i)
+                    m_FiredParallelHandlers.emplace_back(index, i);
+            }
+
+            if (next != emitted.end() && next->first == index) {
+                for (const auto& payload : next->second)
+                    for (std::size_t i = 0, count = m_EventChannels[index].payloadHandlers.size(); i < count; ++i) {
+                        const auto handler = m_EventChannels[index].payloadHandlers[i];
+                        handler(payload);
+                    }
+                ++next;
+            }
+        }
+
+        // Parallel handlers run once the serial ones are done, and their commands are applied in dispatch order
+        while (m_EventCommandBuffers.size() < m_FiredParallelHandlers.size())
+            m_EventCommandBuffers.push_back(std::make_unique<CommandBuffer>());
+        forEachEventBatch(m_FiredParallelHandlers.size(), [this](const std::size_t i) {
+            const auto& [index, handler] = m_FiredParallelHandlers[i];
+            m_EventChannels[index].parallelHandlers[handler](*m_EventCommandBuffers[i]);
+        });
+        for (std::size_t i = 0; i < m_FiredParallelHandlers.size(); ++i)
+            m_EventCommandBuffers[i]->flush(*this);
+    }
+
+    inline void Context::update() {
+        runStep();
+        runFrame();
+    }
+
+    inline void Context::runStep() {
+        m_TimingWheel.advanceTo(m_Tick);
+        resumeFrameWaiters();
+
+        for (std::size_t pipelineIndex = 0; pipelineIndex < m_SystemPipelines.size();) {
+            const auto chainEnd = m_SystemFusion ? findFusedChain(pipelineIndex) : pipelineIndex + 1;
+            if (chainEnd - pipelineIndex > 1) {
+                runFusedChain(pipelineIndex, chainEnd);
+                swapBuffers();
+            } else if (m_SystemPipelines[pipelineIndex]->update(getWorkerPool(), m_Tick)) {
+                swapBuffers();
+            }
+            for (; pipelineIndex < chainEnd; ++pipelineIndex)
+                resumePipelineWaiters(pipelineIndex);
+        }
+        // Anything waiting on a pipeline that doesn't exist is resumed at the end of the step
+        for (std::size_t pipelineIndex = m_SystemPipelines.size(); pipelineIndex < m_PipelineWaiters.size(); ++pipelineIndex)
+            resumePipelineWaiters(pipelineIndex);
+
+        flushCommands();
+        returnReservedIds();
+        reapTasks();
+        ++m_Tick;
+    }
+
+    // A chain is a run of pipelines holding one fusable system each, all due this tick over the same signature on the same node.
+    // Each component is written by at most one system in it, none covers a double buffered component, and nothing may be waiting on a pipeline before its last
+    inline std::size_t Context::findFusedChain(const std::size_t firstPipeline) const {
+        const auto fusable = [this](const std::size_t pipelineIndex) -> const System* {
+            const auto& pipeline = m_SystemPipelines[pipelineIndex];
+            if (!pipeline || pipeline->getSystems().size() != 1)
+                return nullptr;
+            const auto& system = *pipeline->getSystems().front();
+            // Unfused, each pipeline publishes its double buffered writes before the next one reads them
+            if ((system.getSignature() & m_DoubleBufferedTypes).any())
+                return nullptr;
+            return system.isFusable() && system.isDueOnTick(m_Tick) ? &system : nullptr;
+        };
+
+        const System* first = fusable(firstPipeline);
+        if (!first)
+            return firstPipeline + 1;
+
+        Signature written = first->getWriteSignature();
+        auto endPipeline = firstPipeline + 1;
+        for (; endPipeline < m_SystemPipelines.size(); ++endPipeline) {
+            const System* system = fusable(endPipeline);
+            if (!system || system->getSignature() != first->getSignature() || system->getNumaNode() != first->getNumaNode())
+                break;
+            if ((written & system->getWriteSignature()).any())
+                break;
+            if (endPipeline - 1 < m_PipelineWaiters.size() && !m_PipelineWaiters[endPipeline - 1].empty())
+                break;
+            written |= system->getWriteSignature();
+        }
+        return endPipeline;
+    }
+
+    // Every system in the chain has the same entities, so they take turns on blocks small enough to still be in cache for the next one
+    inline void Context::runFusedChain(const std::size_t firstPipeline, const std::size_t endPipeline) {
+        m_FusedSystems.clear();
+        for (auto pipelineIndex = firstPipeline; pipelineIndex < endPipeline; ++pipelineIndex)
+            m_FusedSystems.push_back(m_SystemPipelines[pipelineIndex]->getSystems().front().get());
+
+        WaitGroup group;
+        getWorkerPool().post(group, [this] {
+            const auto entityIds = m_FusedSystems.front()->getDenseEntities();
+            for (std::size_t begin = 0; begin < entityIds.size(); begin += FUSION_BLOCK_SIZE) {
+                const auto block = entityIds.subspan(begin, std::min(FUSION_BLOCK_SIZE, entityIds.size() - begin));
+                for (auto* system : m_FusedSystems)
+                    system->updateEntities(block);
+            }
+        }, m_FusedSystems.front()->getNumaNode());
+        group.wait();
+    }
+
+    inline void Context::runFrame() {
+        for (const auto& pipeline : m_SystemPipelines)
+            if (pipeline->updateFrame(getWorkerPool()))
+                swapBuffers();
+    }
+
+    inline void Context::swapBuffers() const {
+        for (const auto& storage : m_DoubleBufferedStorages)
+            storage->swapBuffers();
+    }
 
-        // Default destructor
-        ~Context() = default;
+    inline void Context::setFixedTimestep(const float timestep, const unsigned int maxSubsteps) {
+        assert(timestep > 0.0f && maxSubsteps > 0);
+        m_FixedTimestep = timestep;
+        m_MaxSubsteps = maxSubsteps;
+        applySystemUpdateRates();
+    }
 
-    private:
-        std::vector<EntityId> m_EntityList;
-        std::vector<EntityId> m_FreedEntityList;
-        std::array<unsigned int, MAX_ENTITIES> m_EntityIndices;
-        EntityId nextEntityId = 0;
+    inline void Context::setSystemUpdateRate(const std::shared_ptr<System>& system, const float rate) {
+        const auto found = std::ranges::find(m_SystemUpdateRates, system, &std::pair<std::shared_ptr<System>, float>::first);
+        if (found != m_SystemUpdateRates.end())
+            found->second = rate;
+        else
+            m_SystemUpdateRates.emplace_back(system, rate);
+        applySystemUpdateRates();
+    }
 
-        std::array<Signature, MAX_ENTITIES> m_EntitySignatures;
+    inline void Context::applySystemUpdateRates() {
+        std::unordered_map<unsigned int, unsigned int> nextPhases;
+        for (const auto& [system, rate] : m_SystemUpdateRates) {
+            if (rate <= 0.0f) {
+                system->setTickRate(0); // Run once per frame
+                continue;
+            }
+            const auto interval = static_cast<unsigned int>(std::max(1l, std::lround(1.0f / (rate * m_FixedTimestep))));
+            // Stagger systems sharing an interval across different ticks so they don't all land on the same step
+            const auto phase = nextPhases[interval]++ % interval;
+            system->setTickRate(interval, phase);
+        }
+    }
 
-        std::array<std::shared_ptr<IComponentStorage>, MAX_COMPONENTS> m_ComponentStorages;
-        ComponentTypeId nextComponentTypeId = 0;
-        std::map<const char*, ComponentTypeId > m_ComponentTypes;
+    inline unsigned int Context::tick(const float frameTime) {
+        m_Accumulator += frameTime;
 
-        std::vector<std::shared_ptr<System>> m_Systems;
-        std::vector<std::shared_ptr<SystemPipeline>> m_SystemPipelines;
+        unsigned int substeps = 0;
+        while (m_Accumulator >= m_FixedTimestep && substeps < m_MaxSubsteps) {
+            runStep();
+            m_Accumulator -= m_FixedTimestep;
+            ++substeps;
+        }
 
-        std::unordered_map<EventId, EventCondition> m_EventConditions;
-        std::unordered_multimap<EventId, EventHandler> m_EventHandlers;
-    };
-}
+        // Drop whatever we couldn't catch up on, otherwise a slow frame makes the next one slower
+        if (m_Accumulator >= m_FixedTimestep)
+            m_Accumulator = std::fmod(m_Accumulator, m_FixedTimestep);
 
-namespace ECS {
-    // Implement ComponentStorage
+        runFrame();
+        return substeps;
+    }
 
-    // IComponentStorage Overrides
+    // Implement CommandBuffer
     template<typename T>
-    void ComponentStorage<T>::entityDestroyed(const EntityId entityId) {
-        if (has(entityId))
-            return remove(entityId);
+    void CommandBuffer::addComponent(const EntityId entityId, T component) {
+        push([entityId, component = std::move(component)](Context& context) { context.addComponent(entityId, component); });
     }
 
     template<typename T>
-    void ComponentStorage<T>::dump(std::ostream& os) const {
-        for (const auto& index : entityToIndexMap) {
-            if (index == tnull)
-                break;
-            os << "Entity: " << indexToEntityMap[index] << ", " << m_Components[index] << std::endl;
+    void CommandBuffer::removeComponent(const EntityId entityId) {
+        push([entityId](Context& context) { context.removeComponent<T>(entityId); });
+    }
+
+    inline void CommandBuffer::destroyEntity(const EntityId entityId) {
+        push([entityId](Context& context) { context.destroyEntity(entityId); });
+    }
+
+    inline void CommandBuffer::push(std::function<void(Context&)> command) {
+        std::lock_guard lock(m_Mutex);
+        m_Commands.push_back(std::move(command));
+    }
+
+    inline void CommandBuffer::flush(Context& context) {
+        std::vector<std::function<void(Context&)>> commands;
+        {
+            std::lock_guard lock(m_Mutex);
+            commands.swap(m_Commands);
         }
+        for (const auto& command : commands)
+            command(context);
     }
 
-    template<typename T>
-    void ComponentStorage<T>::deserialise(std::istringstream& iss, const EntityId entityId) {
-        T component;
-        iss >> component;
-        add(entityId, component);
+    // Implement BitWriter and BitReader
+    inline void BitWriter::write(const std::uint32_t value, const unsigned int bits) {
+        assert(bits <= 32 && "Values are written 32 bits at most");
+        const auto mask = bits == 32 ? ~std::uint64_t{0} : (std::uint64_t{1} << bits) - 1;
+        m_Scratch |= (value & mask) << m_ScratchBits;
+        m_ScratchBits += bits;
+        for (; m_ScratchBits >= 8; m_ScratchBits -= 8, m_Scratch >>= 8)
+            m_Buffer.push_back(static_cast<std::uint8_t>(m_Scratch));
     }
 
-    // ComponentStorage Methods
-    template<typename T>
-    void ComponentStorage<T>::add(const EntityId entityId, T& component) {
-        const auto& index = m_Components.size();
-        m_Components.push_back(component);
-        entityToIndexMap[entityId] = index;
-        indexToEntityMap[index] = entityId;
+    inline void BitWriter::writeQuantised(const float value, const float min, const float max, const unsigned int bits) {
+        const auto steps = static_cast<float>((std::uint64_t{1} << bits) - 1);
+        const auto normalised = std::clamp((value - min) / (max - min), 0.0f, 1.0f);
+        write(static_cast<std::uint32_t>(std::lround(normalised * steps)), bits);
     }
 
-    template<typename T>
-    void ComponentStorage<T>::remove(const EntityId entityId) {
-        const auto& index = entityToIndexMap[entityId];
-        const auto& lastIndex = m_Components.size() - 1;
-        m_Components[index] = m_Components[lastIndex];
-        entityToIndexMap[indexToEntityMap[lastIndex]] = index;
-        indexToEntityMap[index] = indexToEntityMap[lastIndex];
-        m_Components.pop_back();
-        entityToIndexMap[entityId] = tnull;
-        indexToEntityMap[lastIndex] = tnull;
+    inline void BitWriter::writeSigned(const std::int32_t value, const unsigned int bits) {
+        assert(bits >= 1 && bits <= 32 && "Signed values are written in 1 to 32 bits");
+        const auto limit = std::int64_t{1} << (bits - 1);
+        const auto clamped = static_cast<std::int32_t>(std::clamp<std::int64_t>(value, -limit, limit - 1));
+        write((static_cast<std::uint32_t>(clamped) << 1) ^ static_cast<std::uint32_t>(clamped >> 31), bits);
+    }
+
+    inline void BitWriter::flush() {
+        if (m_ScratchBits > 0)
+            m_Buffer.push_back(static_cast<std::uint8_t>(m_Scratch));
+        m_Scratch = 0;
+        m_ScratchBits = 0;
+    }
+
+    inline std::uint32_t BitReader::read(const unsigned int bits) {
+        assert(bits <= 32 && "Values are read 32 bits at most");
+        while (m_ScratchBits < bits) {
+            if (m_Position == m_Size) {
+                m_Overflowed = true;
+                return 0;
+            }
+            m_Scratch |= static_cast<std::uint64_t>(m_Data[m_Position++]) << m_ScratchBits;
+            m_ScratchBits += 8;
+        }
+        const auto mask = bits == 32 ? ~std::uint64_t{0} : (std::uint64_t{1} << bits) - 1;
+        const auto value = static_cast<std::uint32_t>(m_Scratch & mask);
+        m_Scratch >>= bits;
+        m_ScratchBits -= bits;
+        return value;
+    }
+
+    inline std::int32_t BitReader::readSigned(const unsigned int bits) {
+        const auto zigzag = read(bits);
+        return static_cast<std::int32_t>(zigzag >> 1) ^ -static_cast<std::int32_t>(zigzag & 1);
     }
 
+    inline float BitReader::readQuantised(const float min, const float max, const unsigned int bits) {
+        const auto steps = static_cast<float>((std::uint64_t{1} << bits) - 1);
+        return min + (max - min) * (static_cast<float>(read(bits)) / steps);
+    }
+
+    // Implement Replicator
     template<typename T>
-    T& ComponentStorage<T>::get(const EntityId entityId) {
-        return m_Components[entityToIndexMap[entityId]];
+    void Replicator::replicate(void (*encode)(BitWriter&, const T&), void (*decode)(BitReader&, T&)) {
+        assert(m_Types.size() < MAX_COMPONENTS && "Too many replicated component types.");
+        ComponentStorage<T>* storage = m_Context.getComponentStorage<T>().get(); // Owned by the Context, which outlives us
+        const auto stagedValues = std::make_shared<StagedValues<T>>();
+        m_StagedValues.push_back(stagedValues);
+        StagedValues<T>* staged = stagedValues.get();
+        m_Types.push_back({
+            m_Context.getComponentTypeId<T>(),
+            [storage, encode](BitWriter& writer, const EntityId entityId) { encode(writer, std::as_const(*storage).get(entityId)); },
+            [storage, decode, staged](BitReader& reader, const EntityId entityId) {
+                decode(reader, staged->values.emplace_back(storage->has(entityId) ? std::as_const(*storage).get(entityId) : T{}));
+            },
+            [this, storage, staged](const EntityId entityId) {
+                auto& component = staged->values[staged->next++];
+                if (storage->has(entityId))
+                    storage->modify(entityId) = std::move(component);
+                else
+                    m_Context.addComponent(entityId, std::move(component));
+            },
+            [this, storage](const EntityId entityId) {
+                if (storage->has(entityId))
+                    m_Context.removeComponent<T>(entityId);
+            },
+            [staged] {
+                staged->values.clear();
+                staged->next = 0;
+            }
+        });
     }
 
     template<typename T>
-    bool ComponentStorage<T>::has(const EntityId entityId) const {
-        return entityToIndexMap[entityId] != tnull;
+    void Replicator::setSpatialComponent(float T::* x, float T::* y, const float cellSize) {
+        assert(cellSize > 0.0f && "Cells need a size.");
+        ComponentStorage<T>* storage = m_Context.getComponentStorage<T>().get();
+        m_SpatialStorage = storage;
+        m_Locate = [storage, x, y](const EntityId entityId, float& positionX, float& positionY) {
+            const auto& component = std::as_const(*storage).get(entityId);
+            positionX = component.*x;
+            positionY = component.*y;
+        };
+        m_CellSize = cellSize;
+        m_GridEpoch = 0;
+        m_Cells.clear();
+        m_InGrid = EntityBitmap();
     }
 
-    inline void SystemPipeline::update() const {
-        std::vector<std::future<void>> futures;
+    // Switching between a view and no view resends the full state, as the client holds a different set of entities
+    inline void Replicator::setClientView(const ClientId clientId, const float x, const float y, const float radius) {
+        assert(m_SpatialStorage && "Client views need a spatial component.");
+        auto& client = m_Clients[clientId];
+        if (!client.hasView) {
+            client.baselineEpoch = 0;
+            client.inFlight.clear();
+            // Once packets were sent the client may hold anything, so whatever turns out to be out of view is despawned
+            client.relevant = EntityBitmap();
+            for (EntityId entityId = 0; client.nextSequence != 0 && entityId < std::min(m_Context.nextEntityId.load(std::memory_order_relaxed), MAX_ENTITIES); ++entityId)
+                client.relevant.set(entityId);
+        }
+        client.hasView = true;
+        client.viewX = x;
+        client.viewY = y;
+        client.viewRadius = radius;
+    }
 
-        for (const auto& system : m_Systems)
-            futures.push_back(std::async(std::launch::async, &System::update, system));
+    inline void Replicator::clearClientView(const ClientId clientId) {
+        auto& client = m_Clients[clientId];
+        if (!client.hasView)
+            return;
+        client.hasView = false;
+        client.baselineEpoch = 0;
+        client.inFlight.clear();
+        client.leaving = EntityBitmap();
+    }
 
-        for (auto& future : futures)
-            future.get();
+    inline std::uint64_t Replicator::getCellKey(const float x, const float y) const {
+        const auto cellX = static_cast<std::int32_t>(std::floor(x / m_CellSize));
+        const auto cellY = static_cast<std::int32_t>(std::floor(y / m_CellSize));
+        return static_cast<std::uint64_t>(static_cast<std::uint32_t>(cellX)) << 32 | static_cast<std::uint32_t>(cellY);
     }
 
-    // Implement Context
-    inline EntityId Context::createEntity() {
-        EntityId entityId;
-        if (m_FreedEntityList.empty())
-            entityId = nextEntityId++;
-        else {
-            entityId = m_FreedEntityList.back();
-            m_FreedEntityList.pop_back();
+    // Only entities whose spatial component was written since the last refresh can have changed cell
+    inline void Replicator::refreshGrid(const std::uint32_t epoch) {
+        const auto entityEnd = std::min(m_Context.nextEntityId.load(std::memory_order_relaxed), MAX_ENTITIES);
+        for (EntityId entityId = 0; entityId < entityEnd; ++entityId) {
+            if (m_GridEpoch != 0 && !m_SpatialStorage->changedSince(entityId, m_GridEpoch))
+                continue;
+
+            const bool present = m_SpatialStorage->getPresence().test(entityId);
+            std::uint64_t cell = 0;
+            if (present) {
+                float x, y;
+                m_Locate(entityId, x, y);
+                cell = getCellKey(x, y);
+                if (m_InGrid.test(entityId) && m_EntityCells[entityId] == cell)
+                    continue;
+            }
+            if (m_InGrid.test(entityId)) {
+                const auto it = m_Cells.find(m_EntityCells[entityId]);
+                auto& entities = it->second;
+                *std::find(entities.begin(), entities.end(), entityId) = entities.back();
+                entities.pop_back();
+                if (entities.empty())
+                    m_Cells.erase(it);
+                m_InGrid.reset(entityId);
+            }
+            if (present) {
+                m_Cells[cell].push_back(entityId);
+                m_EntityCells[entityId] = cell;
+                m_InGrid.set(entityId);
+            }
         }
-        addEntity(entityId);
-        return entityId;
+        m_GridEpoch = epoch;
     }
 
-    inline void Context::addEntity(const EntityId entityId) {
-        m_EntityList.push_back(entityId);
-        m_EntityIndices[entityId] = m_EntityList.size() - 1;
+    inline void Replicator::collectRelevant(const Client& client, EntityBitmap& relevant) {
+        // Entities without a position, like game state, are relevant everywhere
+        relevant = EntityBitmap();
+        for (const auto& type : m_Types)
+            relevant |= m_Context.m_ComponentStorages[type.typeId]->getPresence();
+        relevant.andNot(m_SpatialStorage->getPresence());
+
+        const auto radiusSquared = client.viewRadius * client.viewRadius;
+        const auto firstX = static_cast<std::int32_t>(std::floor((client.viewX - client.viewRadius) / m_CellSize));
+        const auto lastX = static_cast<std::int32_t>(std::floor((client.viewX + client.viewRadius) / m_CellSize));
+        const auto firstY = static_cast<std::int32_t>(std::floor((client.viewY - client.viewRadius) / m_CellSize));
+        const auto lastY = static_cast<std::int32_t>(std::floor((client.viewY + client.viewRadius) / m_CellSize));
+        for (auto cellX = firstX; cellX <= lastX; ++cellX) {
+            for (auto cellY = firstY; cellY <= lastY; ++cellY) {
+                const auto it = m_Cells.find(static_cast<std::uint64_t>(static_cast<std::uint32_t>(cellX)) << 32 | static_cast<std::uint32_t>(cellY));
+                if (it == m_Cells.end())
+                    continue;
+                for (const auto& entityId : it->second) {
+                    float x, y;
+                    m_Locate(entityId, x, y);
+                    if ((x - client.viewX) * (x - client.viewX) + (y - client.viewY) * (y - client.viewY) <= radiusSquared)
+                        relevant.set(entityId);
+                }
+            }
+        }
     }
 
-    inline void Context::destroyEntity(const EntityId entityId) {
-        if (m_EntityIndices[entityId] == tnull)
-            return;
+    inline ClientId Replicator::addClient() {
+        for (ClientId clientId = 0; clientId < m_Clients.size(); ++clientId) {
+            if (!m_Clients[clientId].connected) {
+                m_Clients[clientId] = Client();
+                return clientId;
+            }
+        }
+        m_Clients.emplace_back();
+        return static_cast<ClientId>(m_Clients.size() - 1);
+    }
 
-        m_FreedEntityList.push_back(entityId);
-        m_EntitySignatures[entityId].reset();
+    inline void Replicator::removeClient(const ClientId clientId) {
+        m_Clients[clientId] = Client();
+        m_Clients[clientId].connected = false;
+    }
 
-        m_EntityList[m_EntityIndices[entityId]] = m_EntityList.back(); // Move the last entity to the destroyed entity's place
-        m_EntityIndices[m_EntityList.back()] = m_EntityIndices[entityId]; // Update the index of the moved entity
+    // Packet layout: sequence, then per entity a continue bit, id and alive bit, then for each replicated type
+    // a changed bit and, if changed, a present bit followed by the encoded component. A clear continue bit ends it.
+    inline std::uint32_t Replicator::encode(const ClientId clientId, std::vector<std::uint8_t>& packet) {
+        assert(clientId < m_Clients.size() && m_Clients[clientId].connected && "Encoding for a client that isn't connected.");
+        const auto start = std::chrono::steady_clock::now();
+        auto& client = m_Clients[clientId];
+        const auto sequence = client.nextSequence++;
+        const auto baseline = client.baselineEpoch;
+        // Everything written before this point carries an older stamp than the packet
+        const auto epoch = m_Context.advanceChangeEpoch();
 
-        m_EntityList.pop_back(); // Remove the last entity
-        m_EntityIndices[entityId] = tnull; // Invalidate the destroyed entity's index
+        packet.clear();
+        BitWriter writer(packet);
+        writer.write(sequence, 32);
 
-        for (const auto& storage : m_ComponentStorages)
-            if (storage)
-                storage->entityDestroyed(entityId);
+        std::array<IComponentStorage*, MAX_COMPONENTS> storages{};
+        for (std::size_t i = 0; i < m_Types.size(); ++i)
+            storages[i] = m_Context.m_ComponentStorages[m_Types[i].typeId].get();
 
-        for (const auto& system : m_Systems) {
-            if (auto& entities = system->getEntities(); entities.contains(entityId))
-                entities.erase(entityId);
+        std::size_t entities = 0;
+        // Otherwise only what changed since the baseline is sent. A full entity is sent with every type it ever had, present or removed,
+        // so a copy the client kept from an unacknowledged packet can't hold on to stale components (stamps start at epoch 1)
+        const auto writeHeader = [&](const EntityId entityId, const bool alive) {
+            ++entities;
+            writer.writeBool(true);
+            writer.write(entityId, ENTITY_ID_BITS);
+            writer.writeBool(alive);
+        };
+        const auto writeEntity = [&](const EntityId entityId, const bool full) {
+            std::uint64_t changed = 0;
+            for (std::size_t i = 0; i < m_Types.size(); ++i)
+                if (storages[i]->changedSince(entityId, full ? 1 : baseline))
+                    changed |= std::uint64_t{1} << i;
+            if (changed == 0)
+                return;
+
+            const bool alive = m_Context.isAlive(entityId);
+            writeHeader(entityId, alive);
+            if (!alive)
+                return;
+            for (std::size_t i = 0; i < m_Types.size(); ++i) {
+                writer.writeBool(changed >> i & 1);
+                if (!(changed >> i & 1))
+                    continue;
+                const bool present = storages[i]->getPresence().test(entityId);
+                writer.writeBool(present);
+                if (present)
+                    m_Types[i].encode(writer, entityId);
+            }
+        };
+
+        if (!client.hasView) {
+            // Without an acknowledged baseline the client has nothing, so send whatever is present
+            const auto entityEnd = std::min(m_Context.nextEntityId.load(std::memory_order_relaxed), MAX_ENTITIES);
+            for (EntityId entityId = 0; entityId < entityEnd; ++entityId)
+                writeEntity(entityId, baseline == 0);
+            client.stats.relevant = m_Context.m_EntityList.size();
+        } else {
+            refreshGrid(epoch);
+            EntityBitmap relevant;
+            collectRelevant(client, relevant);
+
+            EntityBitmap entered = relevant;
+            entered.andNot(client.relevant);
+            entered.forEach([&](const EntityId entityId) {
+                client.relevanceChangedAt[entityId] = epoch;
+                client.leaving.reset(entityId);
+            });
+            EntityBitmap left = client.relevant;
+            left.andNot(relevant);
+            left.forEach([&](const EntityId entityId) {
+                client.relevanceChangedAt[entityId] = epoch;
+                client.leaving.set(entityId);
+            });
+            client.relevant = relevant;
+
+            // Entering entities are sent in full, and leaving ones despawned, until a packet carrying that is acknowledged
+            EntityBitmap candidates = relevant;
+            candidates |= client.leaving;
+            candidates.forEach([&](const EntityId entityId) {
+                const bool unacknowledged = baseline == 0 || client.relevanceChangedAt[entityId] > baseline;
+                if (!client.leaving.test(entityId))
+                    writeEntity(entityId, unacknowledged);
+                else if (unacknowledged)
+                    writeHeader(entityId, false);
+                else
+                    client.leaving.reset(entityId);
+            });
+            client.stats.relevant = relevant.count();
         }
+        writer.writeBool(false);
+        writer.flush();
+
+        client.inFlight.emplace_back(sequence, epoch);
+        if (client.inFlight.size() > REPLICATION_WINDOW)
+            client.inFlight.pop_front(); // Its ack is ignored, the next acknowledged packet covers it
+        client.stats.bytes = packet.size();
+        client.stats.entities = entities;
+        client.stats.inFlight = client.inFlight.size();
+        client.stats.encodeTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+        return sequence;
     }
 
-    template<typename T>
-    void Context::registerComponentType() {
-        m_ComponentTypes[typeid(T).name()] = nextComponentTypeId;
-        m_ComponentStorages[nextComponentTypeId] = std::make_shared<ComponentStorage<T>>();
-        ++nextComponentTypeId;
+    inline void Replicator::acknowledge(const ClientId clientId, const std::uint32_t sequence) {
+        auto& client = m_Clients[clientId];
+        // Older packets are superseded by this one, as every packet carries full values from a baseline at least as old
+        while (!client.inFlight.empty() && static_cast<std::int32_t>(client.inFlight.front().first - sequence) <= 0) {
+            if (client.inFlight.front().first == sequence)
+                client.baselineEpoch = client.inFlight.front().second;
+            client.inFlight.pop_front();
+        }
+        client.stats.inFlight = client.inFlight.size();
     }
 
-    template<typename T>
-    void Context::addComponent(const EntityId entityId, T component) {
-        getComponentStorage<T>()->add(entityId, component);
-        const auto& typeId = getComponentTypeId<T>();
-        m_EntitySignatures[entityId].set(typeId);
+    inline bool Replicator::apply(const std::vector<std::uint8_t>& packet, std::uint32_t& sequence) {
+        BitReader reader(packet.data(), packet.size());
+        sequence = reader.read(32);
+        if (reader.overflowed() || (m_HasApplied && static_cast<std::int32_t>(sequence - m_LastApplied) <= 0))
+            return false;
 
-        const auto& entitySignature = m_EntitySignatures[entityId];
-        for (const auto& system : m_Systems) {
-            if (const Signature& systemSignature = system->getSignature(); (entitySignature & systemSignature) == systemSignature)
-                system->getEntities().insert(entityId);
+        // Decode everything before touching the replica, so a truncated or malformed packet leaves it as it was
+        m_StagedChanges.clear();
+        for (const auto& type : m_Types)
+            type.clear();
+        while (reader.readBool()) {
+            const EntityId entityId = reader.read(ENTITY_ID_BITS);
+            const bool alive = reader.readBool();
+            if (reader.overflowed() || entityId >= MAX_ENTITIES)
+                return false;
+            if (!alive) {
+                m_StagedChanges.push_back({StagedKind::Destroy, 0, entityId});
+                continue;
+            }
+            m_StagedChanges.push_back({StagedKind::Spawn, 0, entityId});
+            for (std::size_t i = 0; i < m_Types.size(); ++i) {
+                if (!reader.readBool())
+                    continue;
+                const bool present = reader.readBool();
+                if (present)
+                    m_Types[i].decode(reader, entityId);
+                m_StagedChanges.push_back({present ? StagedKind::Set : StagedKind::Remove, static_cast<std::uint8_t>(i), entityId});
+            }
         }
+        if (reader.overflowed())
+            return false;
+
+        for (const auto& change : m_StagedChanges) {
+            switch (change.kind) {
+                case StagedKind::Destroy:
+                    m_Context.destroyEntity(change.entityId);
+                    break;
+                case StagedKind::Spawn:
+                    if (!m_Context.isAlive(change.entityId))
+                        m_Context.addEntity(change.entityId);
+                    break;
+                case StagedKind::Set:
+                    m_Types[change.type].commit(change.entityId);
+                    break;
+                case StagedKind::Remove:
+                    m_Types[change.type].remove(change.entityId);
+                    break;
+            }
+        }
+
+        m_LastApplied = sequence;
+        m_HasApplied = true;
+        return true;
     }
 
+    inline bool LoopbackTransport::receive(std::vector<std::uint8_t>& packet) {
+        if (m_Packets.empty())
+            return false;
+        packet = std::move(m_Packets.front());
+        m_Packets.pop_front();
+        return true;
+    }
+
+    // Implement StaticContext
+    template<typename... Components>
     template<typename T>
-    void Context::removeComponent(const EntityId entityId) {
-        const auto& typeId = getComponentTypeId<T>();
-        m_EntitySignatures[entityId].reset(typeId);
-        getComponentStorage<T>()->remove(entityId);
-        const auto& entitySignature = m_EntitySignatures[entityId];
-        for (const auto& system : m_Systems) {
-            const Signature& systemSignature = system->getSignature();
-            auto& systemEntities = system->getEntities();
-            if ((entitySignature & systemSignature) != systemSignature && systemEntities.contains(entityId))
-                systemEntities.erase(entityId);
+    constexpr ComponentTypeId StaticContext<Components...>::getComponentTypeId() {
+        static_assert((std::is_same_v<T, Components> || ...), "Component type is not part of this StaticContext");
+        static_assert((std::is_same_v<T, Components> + ...) == 1, "Component type appears more than once");
+        ComponentTypeId typeId = 0;
+        (void)((std::is_same_v<T, Components> ? true : (++typeId, false)) || ...);
+        return typeId;
+    }
+
+    template<typename... Components>
+    EntityId StaticContext<Components...>::createEntity() {
+        EntityId entityId;
+        if (!m_FreedEntityList.empty()) {
+            entityId = m_FreedEntityList.back();
+            m_FreedEntityList.pop_back();
+        } else if (nextEntityId < MAX_ENTITIES) {
+            entityId = nextEntityId++;
+        } else {
+            throw std::length_error("Out of entity ids");
         }
+        m_EntityList.push_back(entityId);
+        m_EntityIndices[entityId] = m_EntityList.size() - 1;
+        m_AliveEntities.set(entityId);
+        return entityId;
     }
 
-    template<typename T>
-    T& Context::getComponent(const EntityId entityId) {
-        return getComponentStorage<T>()->get(entityId);
+    template<typename... Components>
+    template<std::size_t... Indices>
+    void StaticContext<Components...>::removeAll(const EntityId entityId, const Signature& signature, std::index_sequence<Indices...>) {
+        ((signature[Indices] ? std::get<Indices>(m_ComponentStorages).remove(entityId) : void()), ...);
+    }
+
+    template<typename... Components>
+    void StaticContext<Components...>::destroyEntity(const EntityId entityId) {
+        if (!isAlive(entityId))
+            return;
+        removeAll(entityId, m_EntitySignatures[entityId], std::index_sequence_for<Components...>());
+        m_EntitySignatures[entityId].reset();
+
+        m_EntityList[m_EntityIndices[entityId]] = m_EntityList.back();
+        m_EntityIndices[m_EntityList.back()] = m_EntityIndices[entityId];
+        m_EntityList.pop_back();
+        m_EntityIndices[entityId] = tnull;
+        m_AliveEntities.reset(entityId);
+        m_FreedEntityList.push_back(entityId);
+    }
+
+    template<typename... Components>
+    void StaticContext<Components...>::destroyEntities(const std::vector<EntityId>& entityIds) {
+        for (const auto& entityId : entityIds)
+            destroyEntity(entityId);
     }
 
+    // Replaces the storage, so it has to happen before any component of the type is added
+    template<typename... Components>
     template<typename T>
-    bool Context::hasComponent(const EntityId entityId) {
-        const auto typeId = getComponentTypeId<T>();
-        return m_EntitySignatures[entityId][typeId];
+    void StaticContext<Components...>::registerComponentType(const StorageMode mode, const AllocationPolicy policy) {
+        assert(getComponentStorage<T>().size() == 0 && "Register component types before adding components.");
+        getComponentStorage<T>() = ComponentStorage<T>(mode, policy);
     }
 
+    template<typename... Components>
     template<typename T>
-    ComponentTypeId Context::getComponentTypeId() {
-        return m_ComponentTypes[typeid(T).name()];
+    void StaticContext<Components...>::addComponent(const EntityId entityId, T component) {
+        getComponentStorage<T>().add(entityId, component);
+        m_EntitySignatures[entityId].set(getComponentTypeId<T>());
     }
 
+    template<typename... Components>
     template<typename T>
-    std::shared_ptr<ComponentStorage<T>> Context::getComponentStorage() {
-        const auto typeId = getComponentTypeId<T>();
-        return std::static_pointer_cast<ComponentStorage<T>>(m_ComponentStorages[typeId]);
+    void StaticContext<Components...>::removeComponent(const EntityId entityId) {
+        getComponentStorage<T>().remove(entityId);
+        m_EntitySignatures[entityId].reset(getComponentTypeId<T>());
     }
 
-    inline void Context::addSystem(const std::shared_ptr<System>& system, unsigned int pipelineIndex) {
-        m_Systems.emplace_back(system);
+    template<typename... Components>
+    void StaticContext<Components...>::swapBuffers() {
+        std::apply([](auto&... storages) { (storages.swapBuffers(), ...); }, m_ComponentStorages);
+    }
 
-        if (m_SystemPipelines.size() <= pipelineIndex)
-            m_SystemPipelines.resize(pipelineIndex + 1);
+    template<typename... Components>
+    void StaticContext<Components...>::collectEntities(const Signature& include, const Signature& exclude, std::vector<EntityId>& entityIds) const {
+        entityIds.clear();
+        EntityBitmap matches = m_AliveEntities;
+        ComponentTypeId typeId = 0;
+        std::apply([&](const auto&... storages) {
+            ((include[typeId] ? (void)(matches &= storages.getPresence()) : exclude[typeId] ? (void)matches.andNot(storages.getPresence()) : void(), ++typeId), ...);
+        }, m_ComponentStorages);
+        matches.forEach([&entityIds](const EntityId entityId) { entityIds.push_back(entityId); });
+    }
 
-        if (!m_SystemPipelines[pipelineIndex])
-            m_SystemPipelines[pipelineIndex] = std::make_shared<SystemPipeline>();
+    // Drives from the smallest of the viewed storages, with the signature test folded to a constant mask
+    template<typename... Components>
+    template<typename... Types, typename Function>
+    void StaticContext<Components...>::view(Function&& function) {
+        static_assert(sizeof...(Types) > 0, "View at least one component type");
+        constexpr auto signature = createSignature<Types...>();
+        const std::array<const IComponentStorage*, sizeof...(Types)> storages{&getComponentStorage<Types>()...};
+        const auto* driving = *std::min_element(storages.begin(), storages.end(), [](const IComponentStorage* a, const IComponentStorage* b) {
+            return a->getPresence().count() < b->getPresence().count();
+        });
+        std::vector<EntityId> entityIds(driving->getPresence().count());
+        std::size_t count = 0;
+        driving->getPresence().forEach([&](const EntityId entityId) {
+            if ((m_EntitySignatures[entityId] & signature) == signature)
+                entityIds[count++] = entityId;
+        });
+        for (std::size_t i = 0; i < count; ++i)
+            function(entityIds[i], getComponentStorage<Types>().get(entityIds[i])...);
+    }
 
-        m_SystemPipelines[pipelineIndex]->addSystem(system);
+    // Implement SharedWorldView
+    template<typename... Components>
+    Signature SharedWorldView<Components...>::createSignature(Context& context) {
+        return context.createSignature<Components...>();
+    }
 
-        const auto& systemSignature = system->getSignature();
-        for (const auto& entityId : m_EntityList) {
-            const auto& entitySignature = m_EntitySignatures[entityId];
-            if ((entitySignature & systemSignature) == systemSignature)
-                system->getEntities().insert(entityId);
+    template<typename... Components>
+    SharedWorldView<Components...>::SharedWorldView(Context& context, const std::string& name)
+        : ExtractionSystem(context, createSignature(context)), m_Name(name.starts_with('/') ? name : "/" + name) {
+        constexpr std::array<std::size_t, sizeof...(Components)> componentSizes{sizeof(Components)...};
+        const std::array<const char*, sizeof...(Components)> componentNames{typeid(Components).name()...};
+
+        // Everything is sized for MAX_ENTITIES up front, so the layout never changes while readers are attached
+        const auto align = [](const std::size_t offset) { return (offset + 63) / 64 * 64; };
+        SharedWorldHeader layout{};
+        layout.layoutVersion = SharedWorldHeader::LAYOUT_VERSION;
+        layout.entitiesOffset = align(sizeof(SharedWorldHeader));
+        layout.columnCount = sizeof...(Components);
+        std::size_t offset = align(layout.entitiesOffset + MAX_ENTITIES * sizeof(SharedEntity));
+        for (std::size_t i = 0; i < sizeof...(Components); ++i) {
+            auto& column = layout.columns[i];
+            std::snprintf(column.name, sizeof(column.name), "%s", componentNames[i]);
+            column.componentSize = static_cast<std::uint32_t>(componentSizes[i]);
+            column.entitiesOffset = offset;
+            column.componentsOffset = align(offset + MAX_ENTITIES * sizeof(EntityId));
+            offset = align(column.componentsOffset + MAX_ENTITIES * componentSizes[i]);
+        }
+        m_Size = layout.size = offset;
+
+#ifdef __linux__
+        if (const int fd = shm_open(m_Name.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0644); fd != -1) {
+            if (ftruncate(fd, static_cast<off_t>(m_Size)) == 0) {
+                if (void* memory = mmap(nullptr, m_Size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0); memory != MAP_FAILED) {
+                    m_Segment = static_cast<std::byte*>(memory);
+                    m_Shared = true;
+                }
+            }
+            close(fd);
+            if (!m_Shared)
+                shm_unlink(m_Name.c_str());
         }
+#endif
+        if (!m_Shared)
+            m_Segment = new std::byte[m_Size]{};
+
+        auto* header = new (m_Segment) SharedWorldHeader{};
+        header->layoutVersion = layout.layoutVersion;
+        header->size = layout.size;
+        header->entitiesOffset = layout.entitiesOffset;
+        header->columnCount = layout.columnCount;
+        std::copy(std::begin(layout.columns), std::end(layout.columns), header->columns);
+        // Readers check the magic last, so they never see a half initialised header
+        std::atomic_ref(header->magic).store(SharedWorldHeader::MAGIC, std::memory_order_release);
     }
 
-    inline void Context::addEvent(const EventId eventId, const EventCondition& eventCondition) {
-        m_EventConditions[eventId] = eventCondition;
+    template<typename... Components>
+    SharedWorldView<Components...>::~SharedWorldView() {
+        // Registered views are owned by the Context, which finishes extracting before it releases them
+#ifdef __linux__
+        if (m_Shared) {
+            munmap(m_Segment, m_Size);
+            shm_unlink(m_Name.c_str());
+            return;
+        }
+#endif
+        delete[] m_Segment;
     }
 
-    inline void Context::addEventHandler(const EventId eventId, const EventHandler& eventHandler) {
-        m_EventHandlers.emplace(eventId, eventHandler);
+    template<typename... Components>
+    void SharedWorldView<Components...>::extract(const FrameSnapshot& snapshot) {
+        auto& header = *reinterpret_cast<SharedWorldHeader*>(m_Segment);
+        const auto sequence = header.sequence.load(std::memory_order_relaxed);
+        header.sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        header.tick = snapshot.getTick();
+        auto* entities = reinterpret_cast<SharedEntity*>(m_Segment + header.entitiesOffset);
+        std::uint32_t entityCount = 0;
+        for (EntityId entityId = 0; entityId < MAX_ENTITIES; ++entityId)
+            if (snapshot.isAlive(entityId))
+                entities[entityCount++] = {entityId, 0, snapshot.getSignature(entityId).to_ullong()};
+        header.entityCount = entityCount;
+        std::size_t index = 0;
+        (publishColumn<Components>(snapshot, header.columns[index++]), ...);
+
+        header.sequence.store(sequence + 2, std::memory_order_release);
     }
 
-    inline void Context::updateEvents() {
-        for (const auto& [eventId, eventCondition] : m_EventConditions) {
-            if (eventCondition()) {
-                const auto& range = m_EventHandlers.equal_range(eventId);
-                for (auto it = range.first; it != range.second; ++it)
-                    it->second();
+    template<typename... Components>
+    template<typename T>
+    void SharedWorldView<Components...>::publishColumn(const FrameSnapshot& snapshot, SharedColumn& column) {
+        const auto& storage = snapshot.getStorage<T>();
+        column.count = static_cast<std::uint32_t>(storage.size());
+        std::memcpy(m_Segment + column.entitiesOffset, storage.entities(), storage.size() * sizeof(EntityId));
+        std::memcpy(m_Segment + column.componentsOffset, storage.data(), storage.size() * sizeof(T));
+    }
+
+    // Implement SharedWorldFrame and SharedWorldReader
+    inline std::span<const SharedEntity> SharedWorldFrame::getEntities() const {
+        if (m_Data.empty())
+            return {};
+        const auto& header = getHeader();
+        return {reinterpret_cast<const SharedEntity*>(m_Data.data() + header.entitiesOffset), header.entityCount};
+    }
+
+    template<typename T>
+    std::span<const T> SharedWorldFrame::getColumn(std::span<const EntityId>* entities) const {
+        if (m_Data.empty())
+            return {};
+        const auto& header = getHeader();
+        for (std::uint32_t i = 0; i < header.columnCount; ++i) {
+            const auto& column = header.columns[i];
+            if (std::strncmp(column.name, typeid(T).name(), sizeof(column.name) - 1) != 0 || column.componentSize != sizeof(T))
+                continue;
+            if (entities)
+                *entities = {reinterpret_cast<const EntityId*>(m_Data.data() + column.entitiesOffset), column.count};
+            return {reinterpret_cast<const T*>(m_Data.data() + column.componentsOffset), column.count};
+        }
+        return {};
+    }
+
+    inline SharedWorldReader::SharedWorldReader(const std::string& name) {
+#ifdef __linux__
+        const auto path = name.starts_with('/') ? name : "/" + name;
+        int protection = PROT_READ | PROT_WRITE;
+        int fd = shm_open(path.c_str(), O_RDWR, 0);
+#if defined(__x86_64__) || defined(__aarch64__)
+        if (fd == -1) {
+            protection = PROT_READ;
+            fd = shm_open(path.c_str(), O_RDONLY, 0);
+        }
+#endif
+        if (fd == -1)
+            return;
+        struct stat status{};
+        if (fstat(fd, &status) == 0 && static_cast<std::size_t>(status.st_size) >= sizeof(SharedWorldHeader)) {
+            if (void* memory = mmap(nullptr, status.st_size, protection, MAP_SHARED, fd, 0); memory != MAP_FAILED) {
+                m_Segment = static_cast<std::byte*>(memory);
+                m_Size = status.st_size;
             }
         }
+        close(fd);
+#else
+        (void)name;
+#endif
     }
 
-    inline void Context::update() const {
-        for (const auto& pipeline : m_SystemPipelines)
-            pipeline->update();
+    inline SharedWorldReader::~SharedWorldReader() {
+#ifdef __linux__
+        if (m_Segment)
+            munmap(m_Segment, m_Size);
+#endif
+    }
+
+    inline bool SharedWorldReader::read(SharedWorldFrame& frame, const unsigned int attempts) const {
+        if (!m_Segment)
+            return false;
+        auto& header = *reinterpret_cast<SharedWorldHeader*>(m_Segment);
+        if (std::atomic_ref(header.magic).load(std::memory_order_acquire) != SharedWorldHeader::MAGIC
+            || header.layoutVersion != SharedWorldHeader::LAYOUT_VERSION || header.size > m_Size)
+            return false;
+
+        frame.m_Data.resize(header.size);
+        for (unsigned int attempt = 0; attempt < attempts; ++attempt) {
+            const auto sequence = header.sequence.load(std::memory_order_acquire);
+            if (sequence & 1) {
+                std::this_thread::yield();
+                continue;
+            }
+            std::memcpy(frame.m_Data.data(), m_Segment, header.size);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (header.sequence.load(std::memory_order_relaxed) == sequence)
+                return true;
+        }
+        frame.m_Data.clear();
+        return false;
+    }
+
+    // Implement awaiters
+    inline void NextFrameAwaiter::await_suspend(const std::coroutine_handle<> handle) const {
+        m_Context.m_NextFrameWaiters.push_back(handle);
+    }
+
+    inline void PipelineAwaiter::await_suspend(const std::coroutine_handle<> handle) const {
+        if (m_Context.m_PipelineWaiters.size() <= m_PipelineIndex)
+            m_Context.m_PipelineWaiters.resize(m_PipelineIndex + 1);
+        m_Context.m_PipelineWaiters[m_PipelineIndex].push_back(handle);
+    }
+
+    template<typename R>
+    void JobAwaiter<R>::await_suspend(const std::coroutine_handle<> handle) {
+        // The awaiter lives in the suspended coroutine's frame, so it outlives the readiness check
+        m_Context.m_JobWaiters.emplace_back([this] { return await_ready(); }, handle);
     }
 
     inline std::ostream& operator<<(std::ostream& os, const Context& context) {
@@ -408,9 +3805,9 @@ namespace ECS {
         os << "# Version: 1.0 \n\n";
         os << "# Entities\n";
         os << "EntityCount: " << context.m_EntityList.size() << std::endl;
-        os << "NextEntityId: " << context.nextEntityId << std::endl;
+        os << "NextEntityId: " << context.nextEntityId.load() << std::endl;
         os << "FreedEntityList: ";
-        for (const auto& entityId : context.m_FreedEntityList)
+        for (const auto& entityId : context.m_FreedEntityList.toVector())
             os << entityId << " ";
         os << std::endl;
 
@@ -444,11 +3841,13 @@ namespace ECS {
             if (key == "EntityCount:") {
                 iss >> entityCount;
             } else if (key == "NextEntityId:") {
-                iss >> context.nextEntityId;
+                EntityId nextEntityId;
+                iss >> nextEntityId;
+                context.nextEntityId = nextEntityId;
             } else if (key == "FreedEntityList:") {
                 EntityId entityId;
                 while (iss >> entityId) {
-                    context.m_FreedEntityList.push_back(entityId);
+                    context.m_FreedEntityList.push(entityId);
                 }
             } else if (key == "Entity:") {
                 if (!inComponentSection) {
@@ -460,6 +3859,7 @@ namespace ECS {
                     iss >> signature;
                     context.m_EntityList.push_back(entityId);
                     context.m_EntityIndices[entityId] = context.m_EntityList.size() - 1;
+                    context.m_AliveEntities.set(entityId);
                     context.m_EntitySignatures[entityId] = std::bitset<MAX_COMPONENTS>(signature);
                 }
                 else {
@@ -481,9 +3881,7 @@ namespace HELPER {
     // System signature creation
     template<typename... Components>
     Signature createSignature(ECS::Context& context) {
-        Signature signature;
-        (..., signature.set(context.getComponentTypeId<Components>()));
-        return signature;
+        return context.createSignature<Components...>();
     }
 
     // Entity creation with components
@@ -561,17 +3959,13 @@ namespace DEMO {
     };
 
 
-    class MovementSystem : public ECS::System {
+    class MovementSystem : public ECS::TypedSystem<MovementSystem, ECS::Write<PositionComponent>, ECS::Read<VelocityComponent>> {
     public:
-        explicit MovementSystem(ECS::Context& context) : System(context, HELPER::createSignature<PositionComponent, VelocityComponent>(context)) {}
+        explicit MovementSystem(ECS::Context& context) : TypedSystem(context) {}
 
-        void update() override {
-            for (const auto& entityId : m_Entities) {
-                auto& position = m_Context.getComponent<PositionComponent>(entityId);
-                auto& velocity = m_Context.getComponent<VelocityComponent>(entityId);
-                position.x += velocity.dx;
-                position.y += velocity.dy;
-            }
+        static void updateEntity(EntityId, PositionComponent& position, const VelocityComponent& velocity) {
+            position.x += velocity.dx;
+            position.y += velocity.dy;
         }
     };
 
@@ -580,11 +3974,12 @@ namespace DEMO {
         explicit RenderSystem(ECS::Context& context) : System(context, HELPER::createSignature<PositionComponent, HealthComponent>(context)) {}
 
         void update() override {
-            for (const auto& entityId : m_Entities) {
-                const auto& position = m_Context.getComponent<PositionComponent>(entityId);
+            forEachEnabled([this](const EntityId entityId) {
+                // Position is double buffered, so this reads last pipeline's positions while MovementSystem writes the next ones
+                const auto& position = m_Context.getPreviousComponent<PositionComponent>(entityId);
                 const auto& health = m_Context.getComponent<HealthComponent>(entityId);
                 std::cout << "Entity " << entityId << " at " << position << " with " << health << std::endl;
-            }
+            });
         }
     };
 
@@ -594,11 +3989,11 @@ namespace DEMO {
 
         void update() override {
             std::cout << "This test system on pipeline 1 will run after Movement System and Render System" << std::endl;
-            for (const auto& entityId : m_Entities) {
+            forEachEnabled([this](const EntityId entityId) {
                 const auto& position = m_Context.getComponent<PositionComponent>(entityId);
                 const auto& velocity = m_Context.getComponent<VelocityComponent>(entityId);
                 std::cout << "Entity " << entityId << " at " << position << " with " << velocity << std::endl;
-            }
+            });
         }
 
         void testFunction() {
@@ -617,9 +4012,9 @@ namespace DEMO {
         explicit TagTestSystem(ECS::Context& context) : System(context, HELPER::createSignature<Tag<"TagTest"_hs>>(context)) {}
 
         void update() override {
-            for (const auto& entityId : m_Entities) {
+            forEachEnabled([](const EntityId entityId) {
                 std::cout << "Entity " << entityId << " has TagTest" << std::endl;
-            }
+            });
         }
     };
 
@@ -627,7 +4022,7 @@ namespace DEMO {
     inline void runDemo() {
         ECS::Context context;
         // Register component types
-        context.registerComponentType<PositionComponent>();
+        context.registerComponentType<PositionComponent>(ECS::StorageMode::DoubleBuffered);
         context.registerComponentType<VelocityComponent>();
         context.registerComponentType<HealthComponent>();
         context.registerComponentType<Tag<"TagTest"_hs>>();
@@ -657,7 +4052,7 @@ namespace DEMO {
             std::cout << "Alternate handler for Event 1" << std::endl;
         });
 
-        context.addEvent(2, [&testSystem] { return testSystem->testCondition(); });
+        context.addEvent(2, EventCondition::bind<&TestSystem::testCondition>());
 
         context.addEventHandler(2, [] {
             std::cout << "Event 2 triggered by TestSystem test condition" << std::endl;
@@ -686,6 +4081,46 @@ namespace DEMO {
 
         std::cout << std::endl << "New ECS Context serialised state:" << std::endl;
         std::cout << context2;
+
+        // test replication, positions are quantised to 1/64 of a unit and health to 12 signed bits
+        ECS::Context replica;
+        replica.registerComponentType<PositionComponent>();
+        replica.registerComponentType<VelocityComponent>();
+        replica.registerComponentType<HealthComponent>();
+        replica.registerComponentType<Tag<"TagTest"_hs>>();
+
+        ECS::Replicator server(context);
+        ECS::Replicator client(replica);
+        for (auto* replicator : {&server, &client}) {
+            replicator->replicate<PositionComponent>(
+                [](ECS::BitWriter& writer, const PositionComponent& position) {
+                    writer.writeQuantised(position.x, -512.0f, 512.0f, 16);
+                    writer.writeQuantised(position.y, -512.0f, 512.0f, 16);
+                },
+                [](ECS::BitReader& reader, PositionComponent& position) {
+                    position.x = reader.readQuantised(-512.0f, 512.0f, 16);
+                    position.y = reader.readQuantised(-512.0f, 512.0f, 16);
+                });
+            replicator->replicate<HealthComponent>(
+                [](ECS::BitWriter& writer, const HealthComponent& health) { writer.writeSigned(health.health, 12); },
+                [](ECS::BitReader& reader, HealthComponent& health) { health.health = reader.readSigned(12); });
+        }
+
+        ECS::LoopbackTransport transport;
+        const auto clientId = server.addClient();
+        std::vector<std::uint8_t> packet;
+        for (int i = 0; i < 2; ++i) {
+            server.encode(clientId, packet);
+            std::cout << std::endl << "Replication packet " << i + 1 << ": " << server.getStats(clientId).entities << " entities in " << server.getStats(clientId).bytes << " bytes" << std::endl;
+            transport.send(packet);
+            std::uint32_t sequence;
+            while (transport.receive(packet))
+                if (client.apply(packet, sequence))
+                    server.acknowledge(clientId, sequence);
+            context.modifyComponent<HealthComponent>(entity2).health -= 10;
+        }
+        std::cout << "Replica state:" << std::endl;
+        std::cout << replica;
     }
 }
 
@@ -0,0 +1,124 @@
+#pragma once
+
+// Minimal benchmark registry and timing helpers, so the benchmarks build with nothing but the ECS header
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace BENCHMARK {
+    struct Case {
+        const char* name;
+        void (*function)();
+    };
+
+    inline std::vector<Case>& getCases() {
+        static std::vector<Case> cases;
+        return cases;
+    }
+
+    struct Registration {
+        Registration(const char* name, void (*function)()) { getCases().push_back({name, function}); }
+    };
+
+    // Keeps the compiler from dropping work whose result is never used
+    template<typename T>
+    void doNotOptimise(const T& value) {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+
+    // Fastest of several runs in nanoseconds, which is the least disturbed by whatever else the machine is doing
+    template<typename Function>
+    double measure(Function&& function, const int repetitions = 7) {
+        auto best = std::chrono::nanoseconds::max();
+        for (int i = 0; i < repetitions; ++i) {
+            const auto start = std::chrono::steady_clock::now();
+            function();
+            best = std::min(best, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start));
+        }
+        return static_cast<double>(best.count());
+    }
+
+    inline void report(const char* benchmark, const char* variant, const double value, const char* unit) {
+        std::cout << std::left << std::setw(28) << benchmark << std::setw(36) << variant << std::right << std::setw(14) << std::fixed
+                  << std::setprecision(1) << value << " " << unit << std::endl;
+    }
+
+    inline void reportUnavailable(const char* benchmark, const char* variant, const char* reason) {
+        std::cout << std::left << std::setw(28) << benchmark << std::setw(36) << variant << std::right << std::setw(14) << "-" << " " << reason << std::endl;
+    }
+
+#ifdef __linux__
+    inline constexpr std::uint32_t HARDWARE_CACHE_EVENT = PERF_TYPE_HW_CACHE;
+    inline constexpr std::uint64_t DTLB_READ_MISSES = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+#else
+    inline constexpr std::uint32_t HARDWARE_CACHE_EVENT = 0;
+    inline constexpr std::uint64_t DTLB_READ_MISSES = 0;
+#endif
+
+    // A hardware counter for this thread. Unavailable outside Linux, in most VMs and when perf_event_paranoid forbids it
+    class PerfCounter {
+    public:
+        PerfCounter(const std::uint32_t type, const std::uint64_t config) {
+#ifdef __linux__
+            perf_event_attr attributes{};
+            attributes.size = sizeof(attributes);
+            attributes.type = type;
+            attributes.config = config;
+            attributes.disabled = 1;
+            attributes.exclude_kernel = 1;
+            attributes.exclude_hv = 1;
+            m_Descriptor = static_cast<int>(syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0));
+#else
+            (void)type;
+            (void)config;
+#endif
+        }
+        ~PerfCounter() {
+#ifdef __linux__
+            if (m_Descriptor >= 0)
+                close(m_Descriptor);
+#endif
+        }
+        PerfCounter(const PerfCounter&) = delete;
+        PerfCounter& operator=(const PerfCounter&) = delete;
+
+        [[nodiscard]] bool isAvailable() const { return m_Descriptor >= 0; }
+
+        // Counts while function runs
+        template<typename Function>
+        std::uint64_t count(Function&& function) {
+            std::uint64_t value = 0;
+#ifdef __linux__
+            if (isAvailable()) {
+                ioctl(m_Descriptor, PERF_EVENT_IOC_RESET, 0);
+                ioctl(m_Descriptor, PERF_EVENT_IOC_ENABLE, 0);
+                function();
+                ioctl(m_Descriptor, PERF_EVENT_IOC_DISABLE, 0);
+                if (read(m_Descriptor, &value, sizeof(value)) != sizeof(value))
+                    value = 0;
+                return value;
+            }
+#endif
+            function();
+            return value;
+        }
+    private:
+        int m_Descriptor = -1;
+    };
+}
+
+#define BENCHMARK_CASE(name) \
+    static void name(); \
+    static const BENCHMARK::Registration name##Registration(#name, name); \
+    static void name()
@@ -0,0 +1,146 @@
+#include "TEngine_ECS.hpp"
+#include "Benchmark.hpp"
+
+#include <cstdlib>
+#include <new>
+
+// Counts every allocation in the benchmark binary, so each variant can report how many it made.
+// Every form of new and delete is replaced, so they all pair malloc with free
+namespace {
+    std::atomic<std::size_t> allocations = 0;
+
+    void* allocate(const std::size_t size) noexcept {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        return std::malloc(size ? size : 1);
+    }
+
+    void* allocateAligned(const std::size_t size, const std::align_val_t alignment) noexcept {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        const auto bytes = static_cast<std::size_t>(alignment);
+        return std::aligned_alloc(bytes, (std::max<std::size_t>(size, 1) + bytes - 1) / bytes * bytes);
+    }
+
+    // Kept out of line: once a delete is inlined, g++ sees free on a pointer from operator new and warns about the mismatch
+    [[gnu::noinline]] void deallocate(void* pointer) noexcept {
+        std::free(pointer);
+    }
+}
+
+void* operator new(const std::size_t size) {
+    if (void* pointer = allocate(size))
+        return pointer;
+    throw std::bad_alloc();
+}
+
+void* operator new[](const std::size_t size) {
+    if (void* pointer = allocate(size))
+        return pointer;
+    throw std::bad_alloc();
+}
+
+void* operator new(const std::size_t size, const std::align_val_t alignment) {
+    if (void* pointer = allocateAligned(size, alignment))
+        return pointer;
+    throw std::bad_alloc();
+}
+
+void* operator new[](const std::size_t size, const std::align_val_t alignment) {
+    if (void* pointer = allocateAligned(size, alignment))
+        return pointer;
+    throw std::bad_alloc();
+}
+
+void* operator new(const std::size_t size, const std::nothrow_t&) noexcept { return allocate(size); }
+void* operator new[](const std::size_t size, const std::nothrow_t&) noexcept { return allocate(size); }
+void* operator new(const std::size_t size, const std::align_val_t alignment, const std::nothrow_t&) noexcept { return allocateAligned(size, alignment); }
+void* operator new[](const std::size_t size, const std::align_val_t alignment, const std::nothrow_t&) noexcept { return allocateAligned(size, alignment); }
+
+void operator delete(void* pointer) noexcept { deallocate(pointer); }
+void operator delete[](void* pointer) noexcept { deallocate(pointer); }
+void operator delete(void* pointer, std::size_t) noexcept { deallocate(pointer); }
+void operator delete[](void* pointer, std::size_t) noexcept { deallocate(pointer); }
+void operator delete(void* pointer, const std::nothrow_t&) noexcept { deallocate(pointer); }
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept { deallocate(pointer); }
+void operator delete(void* pointer, std::align_val_t) noexcept { deallocate(pointer); }
+void operator delete[](void* pointer, std::align_val_t) noexcept { deallocate(pointer); }
+void operator delete(void* pointer, std::size_t, std::align_val_t) noexcept { deallocate(pointer); }
+void operator delete[](void* pointer, std::size_t, std::align_val_t) noexcept { deallocate(pointer); }
+void operator delete(void* pointer, std::align_val_t, const std::nothrow_t&) noexcept { deallocate(pointer); }
+void operator delete[](void* pointer, std::align_val_t, const std::nothrow_t&) noexcept { deallocate(pointer); }
+
+namespace {
+    constexpr std::size_t HANDLER_COUNT = 1000;
+    constexpr int DISPATCH_ROUNDS = 100;
+
+    // Three pointers of captures: past std::function's inline buffer, within a Delegate's
+    struct Target {
+        float value = 0;
+    };
+
+    template<typename Handler>
+    void measureHandlers(const char* variant) {
+        std::vector<Target> targets(HANDLER_COUNT);
+        std::vector<Handler> handlers;
+        handlers.reserve(HANDLER_COUNT);
+        float scale = 1.5f;
+        float offset = 0.5f;
+
+        const auto registerAll = [&] {
+            handlers.clear();
+            for (auto& target : targets)
+                handlers.emplace_back([&target, &scale, &offset] { target.value = target.value * scale + offset; });
+        };
+        const auto before = allocations.load();
+        registerAll();
+        const auto registrationAllocations = allocations.load() - before;
+
+        BENCHMARK::report("delegateHandlers", (std::string(variant) + " registration").c_str(),
+                          BENCHMARK::measure(registerAll) / HANDLER_COUNT, "ns/handler");
+        BENCHMARK::report("delegateHandlers", (std::string(variant) + " registration allocations").c_str(),
+                          static_cast<double>(registrationAllocations) / HANDLER_COUNT, "per handler");
+
+        const auto dispatch = [&] {
+            for (int round = 0; round < DISPATCH_ROUNDS; ++round)
+                for (const auto& handler : handlers)
+                    handler();
+            BENCHMARK::doNotOptimise(targets.front().value);
+        };
+        BENCHMARK::report("delegateHandlers", (std::string(variant) + " dispatch").c_str(),
+                          BENCHMARK::measure(dispatch) / (HANDLER_COUNT * DISPATCH_ROUNDS), "ns/call");
+    }
+}
+
+BENCHMARK_CASE(delegateHandlers) {
+    measureHandlers<std::function<void()>>("std::function");
+    measureHandlers<Delegate<void()>>("Delegate");
+}
+
+// A pipeline's worth of jobs per batch, waited on the way the scheduler does
+BENCHMARK_CASE(poolJobSubmission) {
+    constexpr int JOB_COUNT = 64;
+    ECS::WorkerPool pool;
+    std::atomic<int> sum = 0;
+
+    const auto submitBatch = [&] {
+        std::vector<std::future<void>> futures;
+        for (int i = 0; i < JOB_COUNT; ++i)
+            futures.push_back(pool.submit([&sum, i] { sum.fetch_add(i, std::memory_order_relaxed); }));
+        for (auto& future : futures)
+            future.get();
+    };
+    const auto postBatch = [&] {
+        ECS::WaitGroup group;
+        for (int i = 0; i < JOB_COUNT; ++i)
+            pool.post(group, [&sum, i] { sum.fetch_add(i, std::memory_order_relaxed); });
+        group.wait();
+    };
+
+    for (const auto& [variant, batch] : {std::pair<const char*, std::function<void()>>{"submit", submitBatch}, {"post", postBatch}}) {
+        batch(); // Warms the queues up to the batch size
+        const auto before = allocations.load();
+        batch();
+        const auto made = allocations.load() - before;
+        BENCHMARK::report("poolJobSubmission", (std::string(variant) + " time").c_str(), BENCHMARK::measure(batch) / JOB_COUNT, "ns/job");
+        BENCHMARK::report("poolJobSubmission", (std::string(variant) + " allocations").c_str(), static_cast<double>(made) / JOB_COUNT, "per job");
+    }
+}
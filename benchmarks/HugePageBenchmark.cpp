@@ -0,0 +1,77 @@
+#include "TEngine_ECS.hpp"
+#include "Benchmark.hpp"
+
+#include <fstream>
+#include <random>
+#include <string>
+
+namespace {
+    // 2 KiB, so a full column of MAX_ENTITIES fills one huge page: the largest column this tree can hold
+    struct WideComponent {
+        float values[512];
+        friend std::ostream& operator<<(std::ostream& os, const WideComponent&) { return os; }
+        friend std::istream& operator>>(std::istream& is, WideComponent&) { return is; }
+    };
+
+    // AnonHugePages of the mapping holding address, read from /proc/self/smaps. 0 where that can't be read
+    std::size_t hugePageBytes(const void* address) {
+        const auto target = reinterpret_cast<std::uintptr_t>(address);
+        std::ifstream smaps("/proc/self/smaps");
+        std::string line;
+        bool inMapping = false;
+        while (std::getline(smaps, line)) {
+            std::uintptr_t begin = 0, end = 0;
+            if (std::sscanf(line.c_str(), "%lx-%lx ", &begin, &end) == 2 && line.find(':') > line.find(' ')) {
+                inMapping = target >= begin && target < end;
+                continue;
+            }
+            std::size_t kilobytes = 0;
+            if (inMapping && std::sscanf(line.c_str(), "AnonHugePages: %zu kB", &kilobytes) == 1)
+                return kilobytes * 1024;
+        }
+        return 0;
+    }
+
+    void measureColumn(const char* variant, const ECS::AllocationPolicy policy) {
+        constexpr int linesPerComponent = sizeof(WideComponent) / 64;
+
+        ECS::Context context;
+        context.registerComponentType<WideComponent>(ECS::StorageMode::Single, policy);
+        std::vector<EntityId> order;
+        for (EntityId i = 0; i < MAX_ENTITIES; ++i) {
+            const auto entityId = context.createEntity();
+            context.addComponent(entityId, WideComponent{});
+            order.push_back(entityId);
+        }
+        std::shuffle(order.begin(), order.end(), std::mt19937(42));
+
+        // Random entity order, a different cache line of each component every sweep, so nearly every access needs its page translated
+        const auto storage = context.getComponentStorage<WideComponent>();
+        const auto& column = std::as_const(*storage);
+        const auto pass = [&column, &order] {
+            float sum = 0;
+            for (int line = 0; line < linesPerComponent; ++line)
+                for (const auto& entityId : order)
+                    sum += column.get(entityId).values[line * 16];
+            BENCHMARK::doNotOptimise(sum);
+        };
+
+        const auto accesses = static_cast<double>(linesPerComponent) * MAX_ENTITIES;
+        BENCHMARK::report("hugePageColumns", (std::string(variant) + " access time").c_str(), BENCHMARK::measure(pass) / accesses, "ns/access");
+
+        BENCHMARK::PerfCounter dtlbMisses(BENCHMARK::HARDWARE_CACHE_EVENT, BENCHMARK::DTLB_READ_MISSES);
+        const auto misses = dtlbMisses.count(pass);
+        if (dtlbMisses.isAvailable())
+            BENCHMARK::report("hugePageColumns", (std::string(variant) + " dTLB load misses").c_str(), static_cast<double>(misses), "per pass");
+        else
+            BENCHMARK::reportUnavailable("hugePageColumns", (std::string(variant) + " dTLB load misses").c_str(), "no hardware counters");
+
+        BENCHMARK::report("hugePageColumns", (std::string(variant) + " column on huge pages").c_str(),
+                          static_cast<double>(hugePageBytes(column.data())) / 1024.0, "KiB");
+    }
+}
+
+BENCHMARK_CASE(hugePageColumns) {
+    measureColumn("Default", ECS::AllocationPolicy::Default);
+    measureColumn("HugePages", ECS::AllocationPolicy::HugePages);
+}
@@ -0,0 +1,73 @@
+#include "TEngine_ECS.hpp"
+#include "Benchmark.hpp"
+
+#include <random>
+
+namespace {
+    struct Position {
+        float x = 0, y = 0;
+        friend std::ostream& operator<<(std::ostream& os, const Position& position) { return os << position.x << " " << position.y; }
+        friend std::istream& operator>>(std::istream& is, Position& position) { return is >> position.x >> position.y; }
+    };
+
+    struct Health {
+        int health = 0;
+        friend std::ostream& operator<<(std::ostream& os, const Health& health) { return os << health.health; }
+        friend std::istream& operator>>(std::istream& is, Health& health) { return is >> health.health; }
+    };
+
+    // Encodes once to warm up, then takes the best of several encodes of the same state
+    double measureEncode(ECS::Replicator& replicator, const ClientId clientId, std::vector<std::uint8_t>& packet) {
+        return BENCHMARK::measure([&] { replicator.encode(clientId, packet); });
+    }
+}
+
+// The tree holds MAX_ENTITIES entities, so that is the largest world this can replicate
+BENCHMARK_CASE(replication) {
+    ECS::Context context;
+    context.registerComponentType<Position>();
+    context.registerComponentType<Health>();
+    ECS::Replicator replicator(context);
+    replicator.replicate<Position>(
+        [](ECS::BitWriter& writer, const Position& position) {
+            writer.writeQuantised(position.x, -512.0f, 512.0f, 16);
+            writer.writeQuantised(position.y, -512.0f, 512.0f, 16);
+        },
+        [](ECS::BitReader& reader, Position& position) {
+            position.x = reader.readQuantised(-512.0f, 512.0f, 16);
+            position.y = reader.readQuantised(-512.0f, 512.0f, 16);
+        });
+    replicator.replicate<Health>(
+        [](ECS::BitWriter& writer, const Health& health) { writer.writeSigned(health.health, 12); },
+        [](ECS::BitReader& reader, Health& health) { health.health = reader.readSigned(12); });
+
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> coordinate(-500.0f, 500.0f);
+    std::vector<EntityId> entityIds;
+    for (EntityId i = 0; i < MAX_ENTITIES; ++i) {
+        const auto entityId = context.createEntity();
+        context.addComponent(entityId, Position{coordinate(random), coordinate(random)});
+        context.addComponent(entityId, Health{100});
+        entityIds.push_back(entityId);
+    }
+
+    const auto clientId = replicator.addClient();
+    std::vector<std::uint8_t> packet;
+    const auto fullTime = measureEncode(replicator, clientId, packet);
+    BENCHMARK::report("replication", "full state size", static_cast<double>(packet.size()), "bytes");
+    BENCHMARK::report("replication", "full state encode", fullTime / 1000.0, "us");
+    BENCHMARK::report("replication", "text serialisation size", static_cast<double>((std::ostringstream() << context).str().size()), "bytes");
+
+    // Every packet from here is a delta against the acknowledged full state
+    replicator.acknowledge(clientId, replicator.encode(clientId, packet));
+    for (const auto percent : {0, 10, 100}) {
+        std::shuffle(entityIds.begin(), entityIds.end(), random);
+        for (std::size_t i = 0; i < entityIds.size() * percent / 100; ++i)
+            context.modifyComponent<Position>(entityIds[i]).x += 1.0f;
+        const auto deltaTime = measureEncode(replicator, clientId, packet);
+        const auto variant = std::to_string(percent) + "% moved";
+        BENCHMARK::report("replication", (variant + " delta size").c_str(), static_cast<double>(packet.size()), "bytes");
+        BENCHMARK::report("replication", (variant + " delta encode").c_str(), deltaTime / 1000.0, "us");
+        replicator.acknowledge(clientId, replicator.encode(clientId, packet));
+    }
+}
@@ -0,0 +1,76 @@
+#include "TEngine_ECS.hpp"
+#include "Benchmark.hpp"
+
+namespace {
+    struct Position {
+        float x = 0, y = 0;
+        friend std::ostream& operator<<(std::ostream& os, const Position& position) { return os << position.x << " " << position.y; }
+        friend std::istream& operator>>(std::istream& is, Position& position) { return is >> position.x >> position.y; }
+    };
+
+    struct Velocity {
+        float x = 0, y = 0;
+        friend std::ostream& operator<<(std::ostream& os, const Velocity& velocity) { return os << velocity.x << " " << velocity.y; }
+        friend std::istream& operator>>(std::istream& is, Velocity& velocity) { return is >> velocity.x >> velocity.y; }
+    };
+
+    struct Health {
+        int health = 0;
+        friend std::ostream& operator<<(std::ostream& os, const Health& health) { return os << health.health; }
+        friend std::istream& operator>>(std::istream& is, Health& health) { return is >> health.health; }
+    };
+
+    constexpr int ROUNDS = 100;
+
+    // The same code runs against both, which is the switch the StaticContext is meant to allow
+    template<typename World>
+    void measureWorld(World& world, const char* variant) {
+        world.template registerComponentType<Position>();
+        world.template registerComponentType<Velocity>();
+        world.template registerComponentType<Health>();
+        std::vector<EntityId> entityIds;
+        for (EntityId i = 0; i < MAX_ENTITIES; ++i) {
+            const auto entityId = world.createEntity();
+            world.addComponent(entityId, Position{static_cast<float>(i), 0});
+            if (i % 2 == 0)
+                world.addComponent(entityId, Velocity{1, 1});
+            world.addComponent(entityId, Health{100});
+            entityIds.push_back(entityId);
+        }
+
+        const auto view = [&world] {
+            for (int round = 0; round < ROUNDS; ++round)
+                world.template view<Position, Velocity>([](const EntityId, Position& position, const Velocity& velocity) {
+                    position.x += velocity.x;
+                    position.y += velocity.y;
+                });
+        };
+        BENCHMARK::report("staticContext", (std::string(variant) + " view").c_str(), BENCHMARK::measure(view) / (ROUNDS * MAX_ENTITIES / 2), "ns/entity");
+
+        const auto access = [&world, &entityIds] {
+            float sum = 0;
+            for (int round = 0; round < ROUNDS; ++round)
+                for (const auto& entityId : entityIds)
+                    if (world.template hasComponent<Velocity>(entityId))
+                        sum += world.template getComponent<Position>(entityId).x + world.template getComponent<Velocity>(entityId).x;
+            BENCHMARK::doNotOptimise(sum);
+        };
+        BENCHMARK::report("staticContext", (std::string(variant) + " component access").c_str(),
+                          BENCHMARK::measure(access) / (ROUNDS * MAX_ENTITIES), "ns/entity");
+
+        const auto churn = [&world, &entityIds] {
+            for (const auto& entityId : entityIds) {
+                world.template removeComponent<Health>(entityId);
+                world.addComponent(entityId, Health{50});
+            }
+        };
+        BENCHMARK::report("staticContext", (std::string(variant) + " remove and add").c_str(), BENCHMARK::measure(churn) / MAX_ENTITIES, "ns/entity");
+    }
+}
+
+BENCHMARK_CASE(staticContext) {
+    ECS::Context context;
+    measureWorld(context, "Context");
+    ECS::StaticContext<Position, Velocity, Health> staticContext;
+    measureWorld(staticContext, "StaticContext");
+}
@@ -0,0 +1,10 @@
+#include "Benchmark.hpp"
+
+// Runs every benchmark, or only those whose name contains the first argument
+int main(const int argc, char** argv) {
+    for (const auto& benchmarkCase : BENCHMARK::getCases()) {
+        if (argc > 1 && std::strstr(benchmarkCase.name, argv[1]) == nullptr)
+            continue;
+        benchmarkCase.function();
+    }
+}
@@ -0,0 +1,77 @@
+#include "TEngine_ECS.hpp"
+#include "Test.hpp"
+
+namespace {
+    struct Counter {
+        int count = 0;
+        void increment() { ++count; }
+        [[nodiscard]] int add(const int value) const { return count + value; }
+    };
+
+    int twice(const int value) { return value * 2; }
+}
+
+TEST_CASE(delegatesBindMembersAndFreeFunctions) {
+    Counter counter;
+    const auto increment = Delegate<void()>::bind<&Counter::increment>(&counter);
+    increment();
+    increment();
+    CHECK(counter.count == 2);
+    CHECK(Delegate<int(int)>::bind<&Counter::add>(&counter)(3) == 5);
+    CHECK(Delegate<int(int)>::bind<&twice>()(4) == 8);
+    CHECK(!Delegate<void()>());
+}
+
+// A shared_ptr capture isn't trivially copyable, so copies and moves go through the manager and must keep the count right
+TEST_CASE(delegatesCopyMoveAndDestroyTheirCallable) {
+    const auto shared = std::make_shared<int>(7);
+    {
+        Delegate<int()> original([shared] { return *shared; });
+        CHECK(shared.use_count() == 2);
+
+        auto copy = original;
+        CHECK(shared.use_count() == 3);
+        CHECK(copy() == 7);
+
+        auto moved = std::move(copy);
+        CHECK(!copy);
+        CHECK(shared.use_count() == 3);
+        CHECK(moved() == 7);
+
+        moved = original;
+        CHECK(shared.use_count() == 3);
+        original.reset();
+        CHECK(shared.use_count() == 2);
+    }
+    CHECK(shared.use_count() == 1);
+}
+
+TEST_CASE(postedJobsAllRunBeforeTheGroupIsDone) {
+    ECS::WorkerPool pool;
+    std::atomic<int> ran = 0;
+    for (int round = 0; round < 3; ++round) {
+        ECS::WaitGroup group;
+        for (int i = 0; i < 100; ++i)
+            pool.post(group, [&ran] { ran.fetch_add(1, std::memory_order_relaxed); });
+        group.wait();
+        CHECK(ran == (round + 1) * 100);
+    }
+}
+
+TEST_CASE(waitRethrowsWhatAPostedJobThrew) {
+    ECS::WorkerPool pool;
+    ECS::WaitGroup group;
+    std::atomic<int> ran = 0;
+    pool.post(group, [] { throw std::runtime_error("job failed"); });
+    for (int i = 0; i < 10; ++i)
+        pool.post(group, [&ran] { ++ran; });
+
+    bool threw = false;
+    try {
+        group.wait();
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    CHECK(threw);
+    CHECK(ran == 10);
+}
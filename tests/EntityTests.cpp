@@ -0,0 +1,125 @@
+#include "TEngine_ECS.hpp"
+#include "Test.hpp"
+
+#include <set>
+
+namespace {
+    // Reserves ids from several threads at once, each keeping the rest of its batch until the step ends
+    std::vector<EntityId> createDeferredOnThreads(ECS::Context& context, const unsigned int threadCount, const unsigned int perThread) {
+        std::vector<std::vector<EntityId>> created(threadCount);
+        std::vector<std::thread> threads;
+        for (unsigned int i = 0; i < threadCount; ++i)
+            threads.emplace_back([&context, &ids = created[i], perThread] {
+                for (unsigned int j = 0; j < perThread; ++j)
+                    ids.push_back(context.createEntityDeferred());
+            });
+        for (auto& thread : threads)
+            thread.join();
+
+        std::vector<EntityId> entityIds;
+        for (const auto& ids : created)
+            entityIds.insert(entityIds.end(), ids.begin(), ids.end());
+        return entityIds;
+    }
+}
+
+TEST_CASE(deferredIdsFromManyThreadsAreUnique) {
+    ECS::Context context;
+    const auto entityIds = createDeferredOnThreads(context, 8, 40);
+    CHECK(std::set<EntityId>(entityIds.begin(), entityIds.end()).size() == entityIds.size());
+
+    context.update();
+    for (const auto& entityId : entityIds)
+        CHECK(context.isAlive(entityId));
+}
+
+TEST_CASE(unusedReservedIdsAreReturnedAtTheEndOfTheStep) {
+    ECS::Context context;
+    // Every thread takes a whole batch but only uses one id of it, several steps in a row
+    std::size_t created = 0;
+    for (int step = 0; step < 20; ++step) {
+        created += createDeferredOnThreads(context, 4, 1).size();
+        context.update();
+    }
+
+    // Nothing was leaked, so the main thread can still fill the context up exactly
+    while (true) {
+        try {
+            context.createEntity();
+            ++created;
+        } catch (const std::length_error&) {
+            break;
+        }
+    }
+    CHECK(created == MAX_ENTITIES);
+}
+
+// Jobs started with runJob keep reserving across steps, so batches are returned while their owners may be using them
+TEST_CASE(deferredIdsStayUniqueWhileStepsReturnBatches) {
+    ECS::Context context;
+    std::atomic<unsigned int> running = 4;
+    std::vector<std::vector<EntityId>> created(running);
+    std::vector<std::thread> threads;
+    for (auto& ids : created)
+        threads.emplace_back([&context, &ids, &running] {
+            for (int i = 0; i < 150; ++i) {
+                ids.push_back(context.createEntityDeferred());
+                std::this_thread::yield(); // Spreads the reservations over many steps
+            }
+            --running;
+        });
+    while (running > 0)
+        context.update();
+    for (auto& thread : threads)
+        thread.join();
+    context.update();
+
+    std::set<EntityId> unique;
+    std::size_t count = 0;
+    for (const auto& ids : created) {
+        unique.insert(ids.begin(), ids.end());
+        count += ids.size();
+    }
+    CHECK(unique.size() == count);
+    for (const auto& entityId : unique)
+        CHECK(context.isAlive(entityId));
+}
+
+TEST_CASE(runningOutOfIdsThrows) {
+    ECS::Context context;
+    for (EntityId i = 0; i < MAX_ENTITIES; ++i)
+        context.createEntity();
+
+    bool threw = false;
+    try {
+        context.createEntity();
+    } catch (const std::length_error&) {
+        threw = true;
+    }
+    CHECK(threw);
+
+    threw = false;
+    try {
+        context.createEntityDeferred();
+    } catch (const std::length_error&) {
+        threw = true;
+    }
+    CHECK(threw);
+
+    // A destroyed entity's id can be used again straight away
+    context.destroyEntity(5);
+    CHECK(context.createEntityDeferred() == 5);
+}
+
+TEST_CASE(serialisedNextEntityIdStaysInRange) {
+    ECS::Context context;
+    for (EntityId i = 0; i < MAX_ENTITIES; ++i)
+        context.createEntity();
+    try {
+        context.createEntityDeferred();
+    } catch (const std::length_error&) {}
+
+    std::stringstream stream;
+    stream << context;
+    CHECK(stream.str().find("NextEntityId: " + std::to_string(MAX_ENTITIES) + "\n") != std::string::npos);
+}
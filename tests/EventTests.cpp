@@ -0,0 +1,116 @@
+#include "TEngine_ECS.hpp"
+#include "Test.hpp"
+
+namespace {
+    // Collects what the payload handler of an event was given in one update
+    std::vector<EventPayload> dispatchOnce(ECS::Context& context, const EventId eventId, const ECS::CoalescePolicy policy) {
+        std::vector<EventPayload> received;
+        context.setEventPolicy(eventId, policy);
+        context.addEventHandler(eventId, PayloadEventHandler([&received](const EventPayload& payload) { received.push_back(payload); }));
+        context.emitEvent(eventId, {1, 1.0f});
+        context.emitEvent(eventId, {2, 5.0f});
+        context.emitEvent(eventId, {1, 2.0f});
+        context.emitEvent(eventId, {1, 3.0f});
+        context.updateEvents();
+        return received;
+    }
+}
+
+TEST_CASE(uncoalescedEventsDispatchEveryEmission) {
+    ECS::Context context;
+    const auto received = dispatchOnce(context, 1, ECS::CoalescePolicy::None);
+    CHECK(received.size() == 4);
+}
+
+TEST_CASE(keepFirstDispatchesOncePerKeyWithTheFirstValue) {
+    ECS::Context context;
+    const auto received = dispatchOnce(context, 1, ECS::CoalescePolicy::KeepFirst);
+    CHECK(received.size() == 2);
+    CHECK(received[0].entity == 1 && received[0].value == 1.0f && received[0].count == 3);
+    CHECK(received[1].entity == 2 && received[1].value == 5.0f && received[1].count == 1);
+}
+
+TEST_CASE(keepLatestDispatchesOncePerKeyWithTheLastValue) {
+    ECS::Context context;
+    const auto received = dispatchOnce(context, 1, ECS::CoalescePolicy::KeepLatest);
+    CHECK(received.size() == 2);
+    CHECK(received[0].entity == 1 && received[0].value == 3.0f && received[0].count == 3);
+}
+
+TEST_CASE(accumulateSumsTheValuesOfEachKey) {
+    ECS::Context context;
+    const auto received = dispatchOnce(context, 1, ECS::CoalescePolicy::Accumulate);
+    CHECK(received.size() == 2);
+    CHECK(received[0].entity == 1 && received[0].value == 6.0f && received[0].count == 3);
+    CHECK(received[1].entity == 2 && received[1].value == 5.0f);
+}
+
+TEST_CASE(lowerLanesAreDispatchedFirst) {
+    ECS::Context context;
+    std::vector<EventId> order;
+    for (const EventId eventId : {1u, 2u, 3u}) {
+        context.addEvent(eventId, [] { return true; });
+        context.addEventHandler(eventId, EventHandler([&order, eventId] { order.push_back(eventId); }));
+    }
+    context.setEventPolicy(1, ECS::CoalescePolicy::None, 2);
+    context.setEventPolicy(3, ECS::CoalescePolicy::None, 1);
+    context.updateEvents();
+    CHECK((order == std::vector<EventId>{2, 3, 1}));
+}
+
+// Registering events from a handler grows the channel list, which used to leave the dispatch loop holding a dangling reference
+TEST_CASE(handlersMayRegisterEventsWhileBeingDispatched) {
+    ECS::Context context;
+    int fired = 0;
+    int late = 0;
+    context.addEvent(1, [] { return true; });
+    context.addEventHandler(1, EventHandler([&context, &fired, &late] {
+        if (fired++ > 0)
+            return;
+        for (EventId eventId = 100; eventId < 200; ++eventId)
+            context.addEvent(eventId, [] { return true; });
+        context.addEventHandler(1, EventHandler([&late] { ++late; }));
+        context.addEventHandler(150, EventHandler([&late] { ++late; }));
+    }));
+    context.addEventHandler(1, PayloadEventHandler([&context](const EventPayload&) {
+        context.emitEvent(1, {});
+    }));
+    context.emitEvent(1, {});
+
+    context.updateEvents();
+    CHECK(fired == 1);
+    CHECK(late == 0);
+
+    // The handlers added during the first dispatch, and the payload emitted from one, are picked up on the next update
+    context.updateEvents();
+    CHECK(fired == 2);
+    CHECK(late == 2);
+}
+
+// Only writes re-evaluate a reactive condition: plain and const reads, including through views, leave it cached
+TEST_CASE(reactiveConditionsOnlySeeWrites) {
+    using namespace DEMO;
+    ECS::Context context;
+    context.registerComponentType<HealthComponent>();
+    const auto entityId = HELPER::createEntityWithComponents(context, HealthComponent{10});
+    int evaluations = 0;
+    context.addEvent(1, [&context, &evaluations, entityId] {
+        ++evaluations;
+        return context.readComponent<HealthComponent>(entityId).health <= 0;
+    }, context.createSignature<HealthComponent>(), {entityId});
+    context.updateEvents();
+    CHECK(evaluations == 1);
+
+    CHECK(context.getComponent<HealthComponent>(entityId).health == 10);
+    context.view<HealthComponent>([](EntityId, const HealthComponent&) {});
+    context.updateEvents();
+    CHECK(evaluations == 1);
+
+    context.modifyComponent<HealthComponent>(entityId).health = 0;
+    context.updateEvents();
+    CHECK(evaluations == 2);
+
+    context.view<HealthComponent>([](EntityId, HealthComponent& health) { health.health = 5; });
+    context.updateEvents();
+    CHECK(evaluations == 3);
+}
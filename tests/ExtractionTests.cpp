@@ -0,0 +1,124 @@
+#include "TEngine_ECS.hpp"
+#include "Test.hpp"
+
+using namespace DEMO;
+
+namespace {
+    class RecordingExtractionSystem : public ECS::ExtractionSystem {
+    public:
+        explicit RecordingExtractionSystem(ECS::Context& context) : ExtractionSystem(context, HELPER::createSignature<PositionComponent>(context)) {}
+
+        void extract(const ECS::FrameSnapshot& snapshot) override {
+            positions.clear();
+            for (const auto& entityId : m_Entities) {
+                hasVelocity = hasVelocity || snapshot.hasComponent<VelocityComponent>(entityId);
+                positions.push_back(snapshot.getComponent<PositionComponent>(entityId).x);
+            }
+            tick = snapshot.getTick();
+        }
+
+        std::vector<float> positions;
+        bool hasVelocity = false;
+        std::uint64_t tick = 0;
+    };
+}
+
+TEST_CASE(extractionReadsTheSnapshotNotTheLiveComponents) {
+    ECS::Context context;
+    context.registerComponentType<PositionComponent>();
+    context.registerComponentType<VelocityComponent>();
+    const auto recorder = std::make_shared<RecordingExtractionSystem>(context);
+    context.addExtractionSystem(recorder);
+
+    const auto entityId = context.createEntity();
+    context.addComponent(entityId, PositionComponent{1, 0});
+    context.addComponent(entityId, VelocityComponent{0, 0});
+    context.extract();
+    context.getComponent<PositionComponent>(entityId).x = 2; // The next frame writing while the last one is extracted
+    context.waitForExtraction();
+
+    CHECK(recorder->positions.size() == 1 && recorder->positions[0] == 1);
+    CHECK(recorder->hasVelocity);
+
+    context.update();
+    context.extract();
+    context.waitForExtraction();
+    CHECK(recorder->positions[0] == 2);
+    CHECK(recorder->tick == 1);
+}
+
+namespace {
+    class ThrowingExtractionSystem : public ECS::ExtractionSystem {
+    public:
+        explicit ThrowingExtractionSystem(ECS::Context& context) : ExtractionSystem(context, HELPER::createSignature<PositionComponent>(context)) {}
+        void extract(const ECS::FrameSnapshot&) override { throw std::runtime_error("extraction failed"); }
+    };
+}
+
+// Extraction has no future of its own any more, so a failure has to come out of the next wait instead
+TEST_CASE(extractionFailuresAreRethrownByTheNextWait) {
+    ECS::Context context;
+    context.registerComponentType<PositionComponent>();
+    context.registerComponentType<VelocityComponent>();
+    const auto recorder = std::make_shared<RecordingExtractionSystem>(context);
+    context.addExtractionSystem(recorder);
+    context.addExtractionSystem(std::make_shared<ThrowingExtractionSystem>(context));
+    context.addComponent(context.createEntity(), PositionComponent{3, 0});
+
+    context.extract();
+    bool thrown = false;
+    try {
+        context.waitForExtraction();
+    } catch (const std::runtime_error&) {
+        thrown = true;
+    }
+    CHECK(thrown);
+    CHECK(recorder->positions.size() == 1 && recorder->positions[0] == 3);
+    context.waitForExtraction(); // Already reported, so waiting again is fine
+}
+
+// A reader copying while frames are published must only ever see whole frames: every position in a frame is its tick
+TEST_CASE(sharedWorldReadersOnlySeeWholeFrames) {
+    ECS::Context context;
+    context.registerComponentType<PositionComponent>();
+    const auto name = "tengine_test_" + std::to_string(getpid());
+    const auto view = std::make_shared<ECS::SharedWorldView<PositionComponent>>(context, name);
+    context.addExtractionSystem(view);
+    if (!view->isShared())
+        return; // No POSIX shared memory here
+
+    for (int i = 0; i < 200; ++i)
+        context.addComponent(context.createEntity(), PositionComponent{0, 0});
+
+    ECS::SharedWorldReader reader(name);
+    CHECK(reader.isOpen());
+    std::atomic<bool> done = false;
+    std::atomic<int> frames = 0;
+    std::atomic<int> torn = 0;
+    std::thread readerThread([&] {
+        ECS::SharedWorldFrame frame;
+        while (!done.load()) {
+            if (!reader.read(frame))
+                continue;
+            const auto positions = frame.getColumn<PositionComponent>();
+            if (positions.size() != 200 && frame.getTick() != 0)
+                ++torn;
+            for (const auto& position : positions)
+                if (position.x != static_cast<float>(frame.getTick()))
+                    ++torn;
+            ++frames;
+        }
+    });
+
+    for (int tick = 0; tick < 500; ++tick) {
+        for (EntityId entityId = 0; entityId < 200; ++entityId)
+            context.getComponent<PositionComponent>(entityId).x = static_cast<float>(context.getTick());
+        context.extract();
+        context.waitForExtraction();
+        context.update();
+    }
+    done = true;
+    readerThread.join();
+    CHECK(frames > 0);
+    CHECK(torn == 0);
+}
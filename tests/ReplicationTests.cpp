@@ -0,0 +1,208 @@
+#include "TEngine_ECS.hpp"
+#include "Test.hpp"
+
+#include <cmath>
+
+namespace {
+    struct Position {
+        float x = 0, y = 0;
+        friend std::ostream& operator<<(std::ostream& os, const Position& position) { return os << position.x << " " << position.y; }
+        friend std::istream& operator>>(std::istream& is, Position& position) { return is >> position.x >> position.y; }
+    };
+
+    struct Health {
+        int health = 0;
+        friend std::ostream& operator<<(std::ostream& os, const Health& health) { return os << health.health; }
+        friend std::istream& operator>>(std::istream& is, Health& health) { return is >> health.health; }
+    };
+
+    void registerReplicated(ECS::Context& context, ECS::Replicator& replicator) {
+        context.registerComponentType<Position>();
+        context.registerComponentType<Health>();
+        replicator.replicate<Position>(
+            [](ECS::BitWriter& writer, const Position& position) {
+                writer.writeQuantised(position.x, -512.0f, 512.0f, 16);
+                writer.writeQuantised(position.y, -512.0f, 512.0f, 16);
+            },
+            [](ECS::BitReader& reader, Position& position) {
+                position.x = reader.readQuantised(-512.0f, 512.0f, 16);
+                position.y = reader.readQuantised(-512.0f, 512.0f, 16);
+            });
+        replicator.replicate<Health>(
+            [](ECS::BitWriter& writer, const Health& health) { writer.writeSigned(health.health, 12); },
+            [](ECS::BitReader& reader, Health& health) { health.health = reader.readSigned(12); });
+    }
+
+    // A server and a replica connected over a loopback transport
+    struct Session {
+        ECS::Context server;
+        ECS::Context replica;
+        ECS::Replicator serverReplicator{server};
+        ECS::Replicator replicaReplicator{replica};
+        ECS::LoopbackTransport transport;
+        ClientId clientId;
+        std::vector<std::uint8_t> packet;
+
+        Session() {
+            registerReplicated(server, serverReplicator);
+            registerReplicated(replica, replicaReplicator);
+            clientId = serverReplicator.addClient();
+        }
+
+        // Sends one packet, applying it on the replica and acknowledging it only if asked to
+        void send(const bool acknowledge = true) {
+            serverReplicator.encode(clientId, packet);
+            transport.send(packet);
+            std::uint32_t sequence;
+            while (transport.receive(packet))
+                if (replicaReplicator.apply(packet, sequence) && acknowledge)
+                    serverReplicator.acknowledge(clientId, sequence);
+        }
+    };
+
+    bool near(const float a, const float b) {
+        return std::abs(a - b) <= 1024.0f / 65535.0f;
+    }
+}
+
+TEST_CASE(bitPackedValuesRoundTrip) {
+    std::vector<std::uint8_t> buffer;
+    ECS::BitWriter writer(buffer);
+    writer.write(5, 3);
+    writer.writeBool(true);
+    writer.write(0xDEADBEEF, 32);
+    writer.writeFloat(-3.25f);
+    writer.writeQuantised(0.3f, 0.0f, 1.0f, 10);
+    writer.writeQuantised(7.0f, 0.0f, 1.0f, 4); // Clamped to max
+    writer.writeSigned(-100, 12);
+    writer.writeSigned(100, 12);
+    writer.writeSigned(-5000, 12); // Clamped to the smallest 12 bit value
+    writer.writeSigned(std::numeric_limits<std::int32_t>::min(), 32);
+    writer.flush();
+    CHECK(buffer.size() == (3 + 1 + 32 + 32 + 10 + 4 + 12 * 3 + 32 + 7) / 8);
+
+    ECS::BitReader reader(buffer.data(), buffer.size());
+    CHECK(reader.read(3) == 5);
+    CHECK(reader.readBool());
+    CHECK(reader.read(32) == 0xDEADBEEF);
+    CHECK(reader.readFloat() == -3.25f);
+    CHECK(std::abs(reader.readQuantised(0.0f, 1.0f, 10) - 0.3f) <= 1.0f / 1023.0f);
+    CHECK(reader.readQuantised(0.0f, 1.0f, 4) == 1.0f);
+    CHECK(reader.readSigned(12) == -100);
+    CHECK(reader.readSigned(12) == 100);
+    CHECK(reader.readSigned(12) == -2048);
+    CHECK(reader.readSigned(32) == std::numeric_limits<std::int32_t>::min());
+    CHECK(!reader.overflowed());
+
+    reader.read(32);
+    CHECK(reader.overflowed());
+}
+
+TEST_CASE(replicaMatchesTheServerOverLoopback) {
+    Session session;
+    std::vector<EntityId> entityIds;
+    for (int i = 0; i < 50; ++i) {
+        const auto entityId = session.server.createEntity();
+        session.server.addComponent(entityId, Position{static_cast<float>(i), -static_cast<float>(i)});
+        session.server.addComponent(entityId, Health{i - 25});
+        entityIds.push_back(entityId);
+    }
+    session.send();
+
+    session.server.modifyComponent<Position>(entityIds[3]).x = 100.0f;
+    session.server.modifyComponent<Health>(entityIds[4]).health = -7;
+    session.server.removeComponent<Health>(entityIds[5]);
+    session.server.destroyEntity(entityIds[6]);
+    session.send();
+    CHECK(session.serverReplicator.getStats(session.clientId).entities == 4);
+
+    for (const auto& entityId : entityIds) {
+        CHECK(session.replica.isAlive(entityId) == session.server.isAlive(entityId));
+        if (!session.server.isAlive(entityId))
+            continue;
+        const auto& position = session.server.getComponent<Position>(entityId);
+        CHECK(near(session.replica.getComponent<Position>(entityId).x, position.x));
+        CHECK(near(session.replica.getComponent<Position>(entityId).y, position.y));
+        CHECK(session.replica.hasComponent<Health>(entityId) == session.server.hasComponent<Health>(entityId));
+        if (session.server.hasComponent<Health>(entityId))
+            CHECK(session.replica.getComponent<Health>(entityId).health == session.server.getComponent<Health>(entityId).health);
+    }
+}
+
+TEST_CASE(unchangedEntitiesAreLeftOutOfDeltas) {
+    Session session;
+    for (int i = 0; i < 20; ++i)
+        session.server.addComponent(session.server.createEntity(), Health{i});
+    session.send();
+    CHECK(session.serverReplicator.getStats(session.clientId).entities == 20);
+
+    session.send();
+    CHECK(session.serverReplicator.getStats(session.clientId).entities == 0);
+}
+
+// Until something is acknowledged every packet is full state, and it must still carry removals and despawns
+TEST_CASE(unacknowledgedFullStateCarriesRemovalsAndDespawns) {
+    Session session;
+    const auto kept = session.server.createEntity();
+    session.server.addComponent(kept, Position{1, 2});
+    session.server.addComponent(kept, Health{10});
+    const auto destroyed = session.server.createEntity();
+    session.server.addComponent(destroyed, Health{20});
+    session.send(false);
+    CHECK(session.replica.hasComponent<Health>(kept));
+    CHECK(session.replica.isAlive(destroyed));
+
+    session.server.removeComponent<Health>(kept);
+    session.server.destroyEntity(destroyed);
+    session.send(false);
+    CHECK(session.replica.isAlive(kept));
+    CHECK(!session.replica.hasComponent<Health>(kept));
+    CHECK(!session.replica.isAlive(destroyed));
+}
+
+TEST_CASE(olderPacketsAreRejected) {
+    Session session;
+    session.server.addComponent(session.server.createEntity(), Health{1});
+    std::vector<std::uint8_t> first, second;
+    session.serverReplicator.encode(session.clientId, first);
+    session.serverReplicator.encode(session.clientId, second);
+
+    std::uint32_t sequence;
+    CHECK(session.replicaReplicator.apply(second, sequence));
+    CHECK(!session.replicaReplicator.apply(first, sequence));
+    second.resize(2);
+    CHECK(!session.replicaReplicator.apply(second, sequence));
+}
+
+// Bits past the end of a truncated packet read as zeros, which must not reach the replica
+TEST_CASE(truncatedPacketsLeaveTheReplicaUntouched) {
+    Session session;
+    std::vector<EntityId> entityIds;
+    for (int i = 0; i < 10; ++i) {
+        const auto entityId = session.server.createEntity();
+        session.server.addComponent(entityId, Position{static_cast<float>(i), 1});
+        session.server.addComponent(entityId, Health{i + 1});
+        entityIds.push_back(entityId);
+    }
+    session.send();
+
+    for (const auto& entityId : entityIds)
+        session.server.modifyComponent<Health>(entityId).health += 100;
+    session.server.removeComponent<Position>(entityIds[0]);
+    session.server.destroyEntity(entityIds[1]);
+    session.serverReplicator.encode(session.clientId, session.packet);
+    auto truncated = session.packet;
+    truncated.resize(truncated.size() - 2);
+
+    std::uint32_t sequence;
+    CHECK(!session.replicaReplicator.apply(truncated, sequence));
+    CHECK(session.replica.isAlive(entityIds[1]));
+    CHECK(session.replica.hasComponent<Position>(entityIds[0]));
+    for (int i = 0; i < 10; ++i)
+        CHECK(session.replica.getComponent<Health>(entityIds[i]).health == i + 1);
+
+    CHECK(session.replicaReplicator.apply(session.packet, sequence));
+    CHECK(!session.replica.isAlive(entityIds[1]));
+    CHECK(!session.replica.hasComponent<Position>(entityIds[0]));
+    CHECK(session.replica.getComponent<Health>(entityIds[9]).health == 110);
+}
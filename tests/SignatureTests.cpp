@@ -0,0 +1,85 @@
+#include "TEngine_ECS.hpp"
+#include "Test.hpp"
+
+using namespace DEMO;
+
+namespace {
+    template<std::size_t... Indices>
+    void registerTags(ECS::Context& context, std::index_sequence<Indices...>) {
+        (context.registerComponentType<Tag<Indices>>(), ...);
+    }
+
+    // More component lists than the cache holds, each built from three of the 24 registered tags
+    template<std::size_t... Indices>
+    bool buildManySignatures(ECS::Context& context, std::index_sequence<Indices...>) {
+        const auto check = [&context]<std::size_t I>(std::integral_constant<std::size_t, I>) {
+            const auto signature = context.createSignature<Tag<I % 8>, Tag<8 + I / 8 % 8>, Tag<16 + I / 64>>();
+            return signature.count() == 3 && signature[context.getComponentTypeId<Tag<I % 8>>()]
+                && signature[context.getComponentTypeId<Tag<8 + I / 8 % 8>>()] && signature[context.getComponentTypeId<Tag<16 + I / 64>>()];
+        };
+        return (check(std::integral_constant<std::size_t, Indices>()) && ...);
+    }
+
+    template<typename Function>
+    bool throwsLogicError(Function&& function) {
+        try {
+            function();
+        } catch (const std::logic_error&) {
+            return true;
+        }
+        return false;
+    }
+}
+
+TEST_CASE(signaturesBuiltFromManyThreadsAgree) {
+    for (int round = 0; round < 20; ++round) {
+        ECS::Context context;
+        context.registerComponentType<HealthComponent>();
+        context.registerComponentType<PositionComponent>();
+        context.registerComponentType<VelocityComponent>();
+        const Signature expected = (std::uint64_t{1} << context.getComponentTypeId<PositionComponent>()) | (std::uint64_t{1} << context.getComponentTypeId<VelocityComponent>());
+
+        std::atomic<int> mismatches = 0;
+        std::vector<std::thread> threads;
+        for (int i = 0; i < 4; ++i)
+            threads.emplace_back([&context, &mismatches, &expected] {
+                if (context.createSignature<PositionComponent, VelocityComponent>() != expected)
+                    ++mismatches;
+            });
+        for (auto& thread : threads)
+            thread.join();
+        CHECK(mismatches == 0);
+    }
+}
+
+TEST_CASE(unregisteredComponentTypesThrow) {
+    ECS::Context context;
+    context.registerComponentType<PositionComponent>();
+    const auto entityId = context.createEntity();
+    CHECK(!context.isComponentRegistered<HealthComponent>());
+    CHECK(throwsLogicError([&] { context.getComponentTypeId<HealthComponent>(); }));
+    CHECK(throwsLogicError([&] { context.getComponentStorage<HealthComponent>(); }));
+    CHECK(throwsLogicError([&] { context.hasComponent<HealthComponent>(entityId); }));
+    CHECK(throwsLogicError([&] { context.createSignature<PositionComponent, HealthComponent>(); }));
+}
+
+TEST_CASE(registeringPastMaxComponentsThrows) {
+    ECS::Context context;
+    registerTags(context, std::make_index_sequence<MAX_COMPONENTS>());
+    bool threw = false;
+    try {
+        context.registerComponentType<HealthComponent>();
+    } catch (const std::length_error&) {
+        threw = true;
+    }
+    CHECK(threw);
+    CHECK(!context.isComponentRegistered<HealthComponent>());
+}
+
+TEST_CASE(componentListsPastTheCacheAreStillBuilt) {
+    ECS::Context context;
+    registerTags(context, std::make_index_sequence<24>());
+    CHECK(buildManySignatures(context, std::make_index_sequence<SIGNATURE_CACHE_SIZE + 64>()));
+    // Again, now that the first ones come from the cache
+    CHECK(buildManySignatures(context, std::make_index_sequence<SIGNATURE_CACHE_SIZE + 64>()));
+}
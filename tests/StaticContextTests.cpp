@@ -0,0 +1,81 @@
+#include "TEngine_ECS.hpp"
+#include "Test.hpp"
+
+using namespace DEMO;
+
+namespace {
+    using World = ECS::StaticContext<PositionComponent, VelocityComponent, HealthComponent>;
+
+    static_assert(World::getComponentTypeId<PositionComponent>() == 0);
+    static_assert(World::getComponentTypeId<HealthComponent>() == 2);
+    constexpr Signature POSITION_AND_HEALTH = World::createSignature<PositionComponent, HealthComponent>();
+    static_assert(POSITION_AND_HEALTH[0] && !POSITION_AND_HEALTH[1] && POSITION_AND_HEALTH[2]);
+
+    // Positions of the entities a view visits, sorted, after the same changes were made to a world
+    template<typename Context>
+    std::vector<std::pair<EntityId, float>> runScenario(Context& context) {
+        context.template registerComponentType<PositionComponent>();
+        context.template registerComponentType<VelocityComponent>();
+        context.template registerComponentType<HealthComponent>();
+
+        std::vector<EntityId> entityIds;
+        for (int i = 0; i < 30; ++i) {
+            const auto entityId = context.createEntity();
+            context.addComponent(entityId, PositionComponent{static_cast<float>(i), 0});
+            if (i % 3 != 0)
+                context.addComponent(entityId, VelocityComponent{1, 0});
+            entityIds.push_back(entityId);
+        }
+        context.template removeComponent<VelocityComponent>(entityIds[1]);
+        context.destroyEntity(entityIds[2]);
+        const auto reused = context.createEntity();
+        context.addComponent(reused, PositionComponent{100, 0});
+        context.addComponent(reused, VelocityComponent{2, 0});
+
+        context.template view<PositionComponent, VelocityComponent>([](const EntityId, PositionComponent& position, const VelocityComponent& velocity) {
+            position.x += velocity.dx;
+        });
+
+        std::vector<std::pair<EntityId, float>> visited;
+        context.template view<PositionComponent, VelocityComponent>([&visited](const EntityId entityId, const PositionComponent& position, const VelocityComponent&) {
+            visited.emplace_back(entityId, position.x);
+        });
+        std::sort(visited.begin(), visited.end());
+        return visited;
+    }
+}
+
+TEST_CASE(staticContextMatchesContext) {
+    ECS::Context context;
+    World world;
+    const auto expected = runScenario(context);
+    CHECK(!expected.empty());
+    CHECK(runScenario(world) == expected);
+}
+
+TEST_CASE(staticContextTracksSignaturesAndReusesIds) {
+    World world;
+    const auto entityId = world.createEntity();
+    world.addComponent(entityId, HealthComponent{5});
+    CHECK(world.hasComponent<HealthComponent>(entityId));
+    CHECK(!world.hasComponent<PositionComponent>(entityId));
+
+    world.destroyEntity(entityId);
+    CHECK(!world.isAlive(entityId));
+    const auto reused = world.createEntity();
+    CHECK(reused == entityId);
+    CHECK(!world.hasComponent<HealthComponent>(reused));
+}
+
+TEST_CASE(staticContextThrowsWhenOutOfIds) {
+    World world;
+    for (EntityId i = 0; i < MAX_ENTITIES; ++i)
+        world.createEntity();
+    bool threw = false;
+    try {
+        world.createEntity();
+    } catch (const std::length_error&) {
+        threw = true;
+    }
+    CHECK(threw);
+}
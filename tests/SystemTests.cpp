@@ -0,0 +1,145 @@
+#include "TEngine_ECS.hpp"
+#include "Test.hpp"
+
+using namespace DEMO;
+
+namespace {
+    class Mover : public ECS::TypedSystem<Mover, ECS::Write<PositionComponent>, ECS::Read<VelocityComponent>> {
+    public:
+        explicit Mover(ECS::Context& context) : TypedSystem(context) {}
+        static void updateEntity(EntityId, PositionComponent& position, const VelocityComponent& velocity) { position.x += velocity.dx; }
+    };
+
+    // Reads what the Mover in the pipeline before it wrote
+    class Follower : public ECS::TypedSystem<Follower, ECS::Read<PositionComponent>, ECS::Write<VelocityComponent>> {
+    public:
+        explicit Follower(ECS::Context& context) : TypedSystem(context) {}
+        static void updateEntity(EntityId, const PositionComponent& position, VelocityComponent& velocity) { velocity.dy = position.x; }
+    };
+
+    // Final positions and velocities after a few steps of a Mover then a Follower, each in its own pipeline
+    std::vector<float> runMoverAndFollower(const bool fusion, const ECS::StorageMode positionMode) {
+        ECS::Context context;
+        context.registerComponentType<PositionComponent>(positionMode);
+        context.registerComponentType<VelocityComponent>();
+        for (int i = 0; i < 600; ++i)
+            HELPER::createEntityWithComponents(context, PositionComponent{0, 0}, VelocityComponent{static_cast<float>(i % 7), 0});
+        context.addSystem(std::make_shared<Mover>(context), 0);
+        context.addSystem(std::make_shared<Follower>(context), 1);
+        context.setSystemFusion(fusion);
+        for (int step = 0; step < 3; ++step)
+            context.update();
+
+        std::vector<float> state;
+        context.view<PositionComponent, VelocityComponent>([&state](EntityId, const PositionComponent& position, const VelocityComponent& velocity) {
+            state.push_back(position.x);
+            state.push_back(velocity.dy);
+        });
+        return state;
+    }
+}
+
+TEST_CASE(fusedChainsMatchUnfusedPipelines) {
+    const auto unfused = runMoverAndFollower(false, ECS::StorageMode::Single);
+    CHECK(unfused.size() == 1200);
+    CHECK(runMoverAndFollower(true, ECS::StorageMode::Single) == unfused);
+}
+
+// A fused chain would only publish the Mover's double buffered writes at its end, so the Follower would read a step behind
+TEST_CASE(systemsOverDoubleBufferedComponentsAreNotFused) {
+    const auto unfused = runMoverAndFollower(false, ECS::StorageMode::DoubleBuffered);
+    CHECK(runMoverAndFollower(true, ECS::StorageMode::DoubleBuffered) == unfused);
+}
+
+namespace {
+    // A plain system that counts the entities it updates
+    class Counter : public ECS::System {
+    public:
+        explicit Counter(ECS::Context& context) : System(context, context.createSignature<PositionComponent>()) {}
+        void update() override {
+            updated = 0;
+            forEachEnabled([this](EntityId) { ++updated; });
+        }
+        int updated = 0;
+    };
+}
+
+TEST_CASE(plainSystemsSkipDisabledEntities) {
+    ECS::Context context;
+    context.registerComponentType<PositionComponent>();
+    const auto counter = std::make_shared<Counter>(context);
+    context.addSystem(counter);
+    const auto disabled = HELPER::createEntityWithComponents(context, PositionComponent{0, 0});
+    const auto componentDisabled = HELPER::createEntityWithComponents(context, PositionComponent{0, 0});
+    HELPER::createEntityWithComponents(context, PositionComponent{0, 0});
+    context.setEntityEnabled(disabled, false);
+    context.setComponentEnabled<PositionComponent>(componentDisabled, false);
+    counter->update();
+    CHECK(counter->updated == 1);
+
+    context.setEntityEnabled(disabled, true);
+    counter->update();
+    CHECK(counter->updated == 2);
+}
+
+// Queries created while something is disabled must hold the same entities as ones created before, since neither is told about toggles
+TEST_CASE(queriesIgnoreTheEnabledBits) {
+    ECS::Context context;
+    context.registerComponentType<PositionComponent>();
+    context.registerComponentType<VelocityComponent>();
+    const auto include = context.createSignature<PositionComponent>();
+    const auto exclude = context.createSignature<VelocityComponent>();
+    const auto before = context.addQuery(include, exclude);
+    const auto disabled = HELPER::createEntityWithComponents(context, PositionComponent{0, 0});
+    const auto velocityDisabled = HELPER::createEntityWithComponents(context, PositionComponent{0, 0}, VelocityComponent{1, 0});
+    const auto plain = HELPER::createEntityWithComponents(context, PositionComponent{0, 0});
+    context.setEntityEnabled(disabled, false);
+    context.setComponentEnabled<VelocityComponent>(velocityDisabled, false);
+
+    const auto after = context.addQuery(include, exclude);
+    for (const auto& query : {before, after}) {
+        CHECK(query->size() == 2);
+        CHECK(query->contains(disabled));
+        CHECK(!query->contains(velocityDisabled));
+        CHECK(query->contains(plain));
+    }
+    CHECK(!context.isEnabledFor(disabled, include));
+    std::vector<EntityId> enabled;
+    after->forEachEnabled(context, [&enabled](const EntityId entityId) { enabled.push_back(entityId); });
+    CHECK(enabled == std::vector<EntityId>{plain});
+
+    // Removing the excluded component then matches both, re-enabling changes nothing
+    context.removeComponent<VelocityComponent>(velocityDisabled);
+    context.setEntityEnabled(disabled, true);
+    for (const auto& query : {before, after}) {
+        CHECK(query->size() == 3);
+        CHECK(query->contains(velocityDisabled));
+    }
+}
+
+// Rates set before the timestep must be converted with the timestep in use when ticking, not the default one
+TEST_CASE(updateRatesFollowTimestepChanges) {
+    ECS::Context context;
+    context.registerComponentType<PositionComponent>();
+    const auto fast = std::make_shared<Counter>(context);
+    const auto slow = std::make_shared<Counter>(context);
+    const auto alsoSlow = std::make_shared<Counter>(context);
+    context.addSystem(fast);
+    context.addSystem(slow);
+    context.addSystem(alsoSlow);
+    context.setSystemUpdateRate(fast, 120.0f);
+    context.setSystemUpdateRate(slow, 10.0f);
+    context.setSystemUpdateRate(alsoSlow, 10.0f);
+    CHECK(slow->getTickInterval() == 6);
+
+    context.setFixedTimestep(1.0f / 120.0f);
+    CHECK(fast->getTickInterval() == 1);
+    CHECK(slow->getTickInterval() == 12);
+    CHECK(alsoSlow->getTickInterval() == 12);
+    CHECK(slow->getTickPhase() != alsoSlow->getTickPhase());
+
+    // Changing a rate keeps its place, so the other systems keep their phases
+    context.setSystemUpdateRate(fast, 0.0f);
+    CHECK(fast->isFrameSystem());
+    CHECK(slow->getTickPhase() == 0 && alsoSlow->getTickPhase() == 1);
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+// Minimal test registry, so the tests build with nothing but the ECS header
+#include <iostream>
+#include <vector>
+
+namespace TEST {
+    struct Case {
+        const char* name;
+        void (*function)();
+    };
+
+    inline std::vector<Case>& getCases() {
+        static std::vector<Case> cases;
+        return cases;
+    }
+
+    inline int failures = 0;
+
+    struct Registration {
+        Registration(const char* name, void (*function)()) { getCases().push_back({name, function}); }
+    };
+
+    inline void fail(const char* file, const int line, const char* expression) {
+        std::cerr << file << ":" << line << ": CHECK(" << expression << ") failed" << std::endl;
+        ++failures;
+    }
+}
+
+#define TEST_CASE(name) \
+    static void name(); \
+    static const TEST::Registration name##Registration(#name, name); \
+    static void name()
+
+#define CHECK(expression) ((expression) ? void() : TEST::fail(__FILE__, __LINE__, #expression))
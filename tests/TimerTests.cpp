@@ -0,0 +1,53 @@
+#include "TEngine_ECS.hpp"
+#include "Test.hpp"
+
+namespace {
+    constexpr std::uint64_t LEVEL_SPAN = ECS::TimingWheel::SLOT_COUNT;
+    constexpr std::uint64_t WHEEL_SPAN = std::uint64_t{1} << (ECS::TimingWheel::LEVEL_BITS * ECS::TimingWheel::LEVEL_COUNT);
+}
+
+// Expiries either side of every level boundary have to cascade down and fire on exactly their tick
+TEST_CASE(timersFireOnTheirTickAcrossEveryLevel) {
+    ECS::TimingWheel wheel;
+    std::vector<std::uint64_t> expiries;
+    for (std::uint64_t span = LEVEL_SPAN; span <= WHEEL_SPAN; span *= LEVEL_SPAN)
+        for (const std::uint64_t expiry : {span - 1, span, span + 1, span * 2 + 3})
+            expiries.push_back(expiry);
+    expiries.push_back(WHEEL_SPAN * 2 + 5); // Waits in the overflow list for a whole wheel turn
+
+    std::vector<std::uint64_t> firedAt(expiries.size(), 0);
+    for (std::size_t i = 0; i < expiries.size(); ++i)
+        wheel.schedule(expiries[i], [&wheel, &firedAt, i] { firedAt[i] = wheel.now(); });
+
+    wheel.advanceTo(WHEEL_SPAN * 3);
+    for (std::size_t i = 0; i < expiries.size(); ++i)
+        CHECK(firedAt[i] == expiries[i]);
+    CHECK(wheel.size() == 0);
+}
+
+TEST_CASE(cancelledTimersDontFireAndStaleIdsAreRejected) {
+    ECS::TimingWheel wheel;
+    int fired = 0;
+    const auto timerId = wheel.schedule(LEVEL_SPAN * 3, [&fired] { ++fired; });
+    CHECK(wheel.cancel(timerId));
+    CHECK(!wheel.cancel(timerId));
+
+    // The slot is reused, and the old id must not cancel the new timer
+    wheel.schedule(10, [&fired] { ++fired; });
+    CHECK(!wheel.cancel(timerId));
+    wheel.advanceTo(LEVEL_SPAN * 4);
+    CHECK(fired == 1);
+}
+
+TEST_CASE(callbacksMayScheduleTimers) {
+    ECS::TimingWheel wheel;
+    std::vector<std::uint64_t> firedAt;
+    std::function<void()> reschedule = [&] {
+        firedAt.push_back(wheel.now());
+        if (firedAt.size() < 4)
+            wheel.schedule(wheel.now() + LEVEL_SPAN, reschedule);
+    };
+    wheel.schedule(LEVEL_SPAN - 1, reschedule);
+    wheel.advanceTo(LEVEL_SPAN * 8);
+    CHECK((firedAt == std::vector<std::uint64_t>{LEVEL_SPAN - 1, LEVEL_SPAN * 2 - 1, LEVEL_SPAN * 3 - 1, LEVEL_SPAN * 4 - 1}));
+}
@@ -0,0 +1,38 @@
+#include "TEngine_ECS.hpp"
+#include "Test.hpp"
+
+TEST_CASE(numaTopologyOnlyListsPinnableCpus) {
+    const auto topology = ECS::NumaTopology::detect();
+    CHECK(topology.getNodeCount() > 0);
+    for (const auto& cpus : topology.nodeCpus) {
+        CHECK(!cpus.empty());
+#ifdef __linux__
+        for (const auto& cpu : cpus)
+            CHECK(cpu < CPU_SETSIZE);
+#endif
+    }
+}
+
+TEST_CASE(workerPoolRunsJobsOnEveryNode) {
+    ECS::WorkerPool pool;
+    std::vector<std::future<unsigned int>> futures;
+    for (unsigned int node = 0; node < pool.getNodeCount(); ++node)
+        futures.push_back(pool.submit([node] { return node; }, node));
+    for (unsigned int node = 0; node < futures.size(); ++node)
+        CHECK(futures[node].get() == node);
+}
+
+TEST_CASE(contextFinishesPoolJobsBeforeDestroyingMembers) {
+    std::atomic<bool> ran = false;
+    {
+        ECS::Context context;
+        context.getCommandBuffer().push([](ECS::Context&) {});
+        // The future is dropped, so only the Context's destructor can wait for this job
+        context.getWorkerPool().submit([&context, &ran] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            context.getCommandBuffer().push([](ECS::Context&) {});
+            ran = true;
+        });
+    }
+    CHECK(ran);
+}
@@ -0,0 +1,15 @@
+#include "Test.hpp"
+
+#include <cstring>
+
+// Runs every test, or only those whose name contains the first argument
+int main(const int argc, char** argv) {
+    for (const auto& testCase : TEST::getCases()) {
+        if (argc > 1 && std::strstr(testCase.name, argv[1]) == nullptr)
+            continue;
+        const auto failuresBefore = TEST::failures;
+        testCase.function();
+        std::cout << (TEST::failures == failuresBefore ? "[PASS] " : "[FAIL] ") << testCase.name << std::endl;
+    }
+    return TEST::failures == 0 ? 0 : 1;
+}